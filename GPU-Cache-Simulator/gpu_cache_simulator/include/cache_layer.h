@@ -6,16 +6,98 @@
 #include "queue.h"
 #include "deque.h"
 #include "priority_queue.h"
+#include "miss_stream.h"
+#include "prefetcher.h"
+#include "dram.h"
+#include "partition.h"
+#include "victim_cache.h"
 
 #define MAX_CACHE_SETS 16384 // Cap for array size
+#define CACHE_MEMO_SLOTS MAX_BLOCKS // One last-line memo per SM (thread block)
 
 typedef enum {
     REPLACEMENT_LRU,
     REPLACEMENT_FIFO,
     REPLACEMENT_LFU,
-    REPLACEMENT_RANDOM
+    REPLACEMENT_RANDOM,
+    REPLACEMENT_SRRIP, // Static RRIP: insert at long re-reference interval
+    REPLACEMENT_BRRIP, // Bimodal RRIP: insert at distant, occasionally long (scan/thrash resistant)
+    REPLACEMENT_DRRIP, // Set dueling between SRRIP and BRRIP
+    REPLACEMENT_SHIP   // SRRIP with insertion predicted per memory-region signature
 } replacement_policy_t;
 
+// --- RRIP-family parameters ---
+// Re-reference prediction values are 2 bits per way, packed into cache_set_t.rrpv, so these
+// policies support at most 32 ways. The trace carries no PC, so SHiP signatures hash the
+// 4KB memory region of the fill instead.
+#define RRIP_MAX_WAYS 32
+#define RRIP_DISTANT 3
+#define RRIP_LONG 2
+#define BRRIP_LONG_INTERVAL 32   // BRRIP inserts 1 in 32 fills at long instead of distant
+#define DRRIP_LEADER_SETS 32     // Leader sets per competing policy
+#define DRRIP_PSEL_MAX 1023      // 10-bit policy selector
+#define SHIP_SIGNATURE_BITS 14
+#define SHIP_REGION_SHIFT 12
+#define SHIP_COUNTER_MAX 7       // 3-bit saturating reuse counters
+
+// --- Shadow tags (UMON-style what-if monitors) ---
+// A layer can carry tag-only copies of itself under other policies or way counts. They see the
+// layer's demand stream on a hashed 1/SHADOW_SAMPLE_RATIO of its sets and nothing else (no next
+// level, no prefetcher). shadows[0] is always the layer's own configuration; its error against
+// the real hit rate corrects the estimates of the others.
+#define CACHE_MAX_SHADOWS 4          // Including the baseline
+#define SHADOW_SAMPLE_RATIO 32
+
+// Way counts with compile-time specialized lookup/LRU kernels (1 = direct-mapped)
+#define CACHE_SPECIALIZED_WAYS(X) X(1) X(4) X(8) X(16)
+// Sets at least this wide (fully associative TLBs, walk caches) find tags through a hash directory
+#define CACHE_DIRECTORY_MIN_WAYS 32
+
+// --- Slices ---
+// A sliced layer splits its sets evenly among slices (an L2 behind several memory partitions).
+// The slice of a line is its low log2(slices) line-address bits XORed with a hash of the
+// remaining bits; those remaining bits then index and tag the line inside its slice. Each slice
+// is therefore exactly an independent cache of num_sets / slices sets.
+#define CACHE_MAX_SLICES 64
+
+typedef enum {
+    SLICE_HASH_LINEAR, // Low line bits only: power-of-two strides camp on one slice
+    SLICE_HASH_XOR,    // XOR-fold of every higher line-bit group into the slice bits
+    SLICE_HASH_MIX     // Multiplicative (Fibonacci) hash of the higher bits
+} slice_hash_t;
+
+// Which sets a layer actually simulates (see cache_layer_create_sampled)
+typedef enum {
+    SET_SAMPLING_NONE,
+    SET_SAMPLING_STRIDED, // Every Nth set
+    SET_SAMPLING_HASHED   // Sets whose hashed index is 0 mod N
+} set_sampling_t;
+
+// Relation of a layer's contents to the layer above it (set on the lower layer)
+typedef enum {
+    INCLUSION_NINE,      // Non-inclusive non-exclusive: misses fill every level, evictions are independent
+    INCLUSION_INCLUSIVE, // Evictions back-invalidate copies in the layer above
+    INCLUSION_EXCLUSIVE  // Lines move up on a hit and are not filled here on a miss; upper victims fill this layer
+} inclusion_policy_t;
+
+typedef enum {
+    WRITE_BACK,    // Write hits dirty the line; data goes down on eviction
+    WRITE_THROUGH  // Write hits update the line and are forwarded to the level below
+} write_hit_policy_t;
+
+typedef enum {
+    WRITE_ALLOCATE,   // Write misses fetch and install the line
+    WRITE_NO_ALLOCATE // Write misses are forwarded to the level below without installing
+} write_miss_policy_t;
+
+// Placement of one line of a line trace in a layer, precomputed by cache_layer_bind_lines
+// (8 bytes, so the tables of large dictionaries stay cache-resident)
+#define CACHE_SLOT_SLICE_BITS 6 // Up to CACHE_MAX_SLICES
+typedef struct {
+    uint32_t tag;
+    uint32_t set_slice; // Set before set sampling, then the slice in the low bits
+} cache_line_slot_t;
+
 // --- Cache Block Structure ---
 typedef struct {
     uint64_t tag;
@@ -23,6 +105,12 @@ typedef struct {
     bool dirty; // Indicates data was modified (needs writeback)
     uint32_t access_time; // For LRU counter
     uint32_t access_count; // For LFU policy
+    uint32_t sector_valid; // Per-sector valid bits (bit 0 only when unsectored)
+    uint32_t sector_dirty; // Per-sector dirty bits
+    uint16_t signature; // SHiP: signature of the fill
+    uint8_t owner; // Partition whose access filled the line
+    bool prefetched; // Filled by a prefetch and not yet demanded
+    uint64_t prefetch_ready; // Cycle the prefetched data arrives
     uint8_t data[CACHE_LINE_SIZE]; // Simulated data storage
 } cache_block_t;
 
@@ -31,11 +119,15 @@ typedef struct {
     cache_block_t* blocks;
     uint32_t associativity;
     uint32_t lru_counter; // Used to track time for blocks in the set
+    uint64_t rrpv;        // RRIP policies: 2-bit re-reference prediction per way
+    uint32_t reused;      // SHiP: per-way bit, re-referenced since fill
     
     // Policy-specific data structures
     queue_t* fifo_queue;
     deque_t* lru_deque;
     priority_queue_t* lfu_heap;
+    hash_table_t* directory; // Tag -> way, kept on fill (wide sets only, NULL = scan the ways)
+    bool touched;            // Filled since creation or the last cache_layer_reset
 } cache_set_t;
 
 // --- Cache Layer (L1, L2, Shared Memory) Structure ---
@@ -48,12 +140,101 @@ typedef struct cache_layer_t {
     uint32_t latency;
     
     uint32_t num_sets;
-    cache_set_t* sets;
+    cache_set_t* sets; // sampled_sets entries
+    uint32_t* touched_sets; // Indices into sets[] of the touched ones, in first-touch order
+    uint32_t num_touched;
+    
+    // Sectoring: tags cover block_size, data moves in sector_size pieces (== block_size when off)
+    uint32_t sector_size;
+    uint32_t sectors_per_line;
+    
+    // Set sampling: accesses to unsampled sets are dropped and counts scaled at report time
+    set_sampling_t set_sampling;
+    uint32_t sample_ratio;
+    uint32_t sampled_sets;  // == num_sets when not sampling
+    uint32_t* set_map;      // Set index -> slot in sets[], UINT32_MAX if not simulated (NULL = identity)
+    uint64_t sampled_out;   // Accesses dropped by set sampling
     hash_table_t* tag_table; // Maps address tag to block index (optional optimization)
     
+    // Slicing (num_slices == 1 when off); demand accesses and misses are counted per slice
+    uint32_t num_slices;
+    uint32_t slice_shift; // log2(num_slices)
+    slice_hash_t slice_hash;
+    uint64_t* slice_accesses;
+    uint64_t* slice_misses;
+    
+    // Line-ID fast path: accesses whose line_id is bound take their line address from the
+    // dictionary and set and tag from line_slots[line_id - 1] instead of dividing the address
+    // (see cache_layer_bind_lines)
+    const uint64_t* line_addrs;    // The dictionary, not owned
+    cache_line_slot_t* line_slots; // Owned, NULL = unbound
+    uint32_t num_line_slots;
+    
+    // RRIP-family state shared by all sets
+    uint32_t psel;        // DRRIP: counts SRRIP-leader misses up, BRRIP-leader misses down
+    uint32_t brrip_fills; // BRRIP throttle counter
+    uint8_t* ship_shct;   // SHiP: signature history counter table (2^SHIP_SIGNATURE_BITS entries)
+    
     uint64_t hits;
     uint64_t misses;
     uint64_t evictions;
+    uint64_t sector_misses;      // Misses whose tag was resident (subset of misses)
+    uint64_t bytes_fetched;      // Traffic from the level below, demand and prefetch
+    uint64_t bytes_written_back; // Dirty data sent to the level below
+    
+    // Last-line memo: where each SM's previous access landed. A repeat of the same line is
+    // checked against that single way instead of scanning the set. Entries are validated
+    // against the block's tag, so evictions never have to invalidate them.
+    uint64_t memo_block_addr[CACHE_MEMO_SLOTS];
+    uint64_t memo_tag[CACHE_MEMO_SLOTS];
+    uint32_t memo_set[CACHE_MEMO_SLOTS];
+    uint32_t memo_way[CACHE_MEMO_SLOTS]; // UINT32_MAX = empty
+    uint64_t fast_path_hits;             // Hits resolved by the memo (included in hits)
+    
+    miss_stream_t* miss_stream; // Optional capture of misses/writebacks sent to next_level (not owned)
+    
+    // Prefetching: fills proposed by the prefetcher are fetched functionally from next_level
+    // (its demand statistics are untouched) and counted separately from demand traffic
+    prefetcher_t* prefetcher;       // Owned, NULL = demand fetch only
+    const uint64_t* clock;          // Simulated time for late-prefetch detection (NULL = never late)
+    uint32_t memory_latency;        // Latency of the backing store below the last level
+    dram_t* memory;                 // DRAM below the last level (not owned, NULL = memory_latency)
+    uint64_t prefetch_requests;     // Candidates proposed
+    uint64_t prefetch_fills;        // Candidates not already resident, installed
+    uint64_t prefetch_memory_fills; // Fills that also missed next_level
+    uint64_t prefetch_useful;       // Prefetched blocks demanded after they arrived
+    uint64_t prefetch_late;         // Prefetched blocks demanded while still in flight
+    uint64_t prefetch_useless;      // Prefetched blocks evicted without a demand access
+    
+    // Write policy and write traffic
+    write_hit_policy_t write_hit;
+    write_miss_policy_t write_miss;
+    uint64_t writes;               // Demand write accesses
+    uint64_t write_hits;
+    uint64_t write_no_allocates;   // Write misses forwarded without installing the line
+    uint64_t write_through_bytes;  // Write data forwarded below (write-through hits, no-allocate misses)
+    uint64_t writebacks_received;  // Dirty lines written back into this layer from above
+    
+    // Inclusion with upper_level (the layer whose misses this one serves)
+    inclusion_policy_t inclusion;
+    struct cache_layer_t* upper_level;
+    uint32_t handoff_valid;          // Exclusive: sectors of the line just moved up by cache_access
+    uint32_t handoff_dirty;
+    uint64_t back_invalidations;     // Upper copies removed by this layer's evictions
+    uint64_t back_invalidated_dirty; // ... whose dirty data joined this layer's writeback
+    uint64_t victim_fills;           // Exclusive: lines installed from upper_level evictions
+    
+    partition_t* partition; // Way partitioning, owned (NULL = all accesses share every way)
+    victim_cache_t* victim; // Buffer for this layer's evictions, owned (NULL = none)
+    
+    // Hot-path kernels picked at creation: unrolled, branch-free variants for the common way
+    // counts (see CACHE_SPECIALIZED_WAYS), generic loops otherwise
+    uint32_t (*find_way)(const cache_set_t* set, uint64_t tag); // associativity if absent
+    uint32_t (*lru_victim)(const cache_set_t* set);             // NULL unless LRU at a specialized width
+    
+    // Shadow tags, owned; all share one set sample so a single lookup filters for them
+    struct cache_layer_t* shadows[CACHE_MAX_SHADOWS];
+    uint32_t num_shadows;
     
     struct cache_layer_t* next_level; // Pointer to the next cache level or global memory
 } cache_layer_t;
@@ -68,9 +249,83 @@ cache_layer_t* cache_layer_create(
     uint32_t latency
 );
 
+// Simulates only a 1/sample_ratio subset of sets, chosen by set_sampling
+cache_layer_t* cache_layer_create_sampled(
+    const char* name,
+    uint32_t size,
+    uint32_t block_size,
+    uint32_t associativity,
+    replacement_policy_t policy,
+    uint32_t latency,
+    set_sampling_t set_sampling,
+    uint32_t sample_ratio
+);
+
+const char* replacement_policy_name(replacement_policy_t policy);
+int replacement_policy_parse(const char* name, replacement_policy_t* policy);
+
+const char* inclusion_policy_name(inclusion_policy_t inclusion);
+int inclusion_policy_parse(const char* name, inclusion_policy_t* inclusion);
+
+// Parses "back|through[:allocate|:no-allocate]"; the miss policy is left alone if omitted
+int write_policy_parse(const char* spec, write_hit_policy_t* hit, write_miss_policy_t* miss);
+const char* write_hit_policy_name(write_hit_policy_t policy);
+const char* write_miss_policy_name(write_miss_policy_t policy);
+
+// Switches the layer to sectored lines; call before the first access.
+// sector_size must divide block_size into at most 32 sectors.
+int cache_layer_set_sectored(cache_layer_t* cache, uint32_t sector_size);
+
+// Installs pf (taking ownership, replacing any previous prefetcher)
+void cache_layer_set_prefetcher(cache_layer_t* cache, prefetcher_t* pf);
+// Installs a victim cache behind the layer (taking ownership); -1 if the next level is exclusive
+int cache_layer_set_victim_cache(cache_layer_t* cache, victim_cache_t* vc);
+// Splits the sets into slices (a power of two dividing the set count); call before any access
+int cache_layer_set_sliced(cache_layer_t* cache, uint32_t slices, slice_hash_t hash);
+int slice_hash_parse(const char* name, slice_hash_t* hash);
+const char* slice_hash_name(slice_hash_t hash);
+// Slice serving address (0 when unsliced)
+uint32_t cache_slice_of(const cache_layer_t* cache, uint64_t address);
+// Precomputes the placement of line IDs 1..num_lines of a line-trace dictionary (lines[id] =
+// address / line_size, which must outlive the binding) for the fast path; call after slicing
+// and set sampling are configured. -1 (left unbound) if line_size is not the layer's block
+// size or a tag does not fit a slot; num_lines 0 unbinds. Shadows keep the address path, and
+// the binding survives cache_layer_reset.
+int cache_layer_bind_lines(cache_layer_t* cache, const uint64_t* lines, uint32_t num_lines, uint32_t line_size);
+// Parallel simulation of a sliced layer: each worker drives a fork that shares the sets but has
+// its own counters and memos, and must only touch lines of its own slices. Forking needs a layer
+// whose replacement decisions depend on nothing outside the set (no prefetcher, partitioning,
+// shadows, victim cache, lower level or set-dueling/shared-table policy); -1 otherwise.
+int cache_layer_can_fork(const cache_layer_t* cache);
+cache_layer_t* cache_layer_fork(cache_layer_t* cache);
+// Adds the fork's counters into cache and frees the fork
+void cache_layer_join(cache_layer_t* cache, cache_layer_t* fork);
+// Returns the layer (and its prefetcher, partitioning, victim cache and shadows) to its state
+// right after creation and configuration, without reallocating; links to other levels are kept
+void cache_layer_reset(cache_layer_t* cache);
+// Re-indexes the tag directories from the blocks and marks every set touched (after the blocks
+// were written directly)
+void cache_layer_rebuild_directories(cache_layer_t* cache);
+// Installs way partitioning (taking ownership, replacing any previous one)
+void cache_layer_set_partition(cache_layer_t* cache, partition_t* part);
+
+// Adds a shadow-tag monitor for (policy, associativity) at the same set count; the first call
+// also adds the baseline shadow. Call after sectoring and write policies are final.
+int cache_layer_add_shadow(cache_layer_t* cache, replacement_policy_t policy, uint32_t associativity);
+// Parses "<policy>[:ways]"; ways is left alone if omitted
+int shadow_spec_parse(const char* spec, replacement_policy_t* policy, uint32_t* associativity);
+
 bool cache_access(cache_layer_t* cache, memory_access_t* access);
+// Accepts a dirty line (sector_mask of it, UINT32_MAX = whole line) written back from above
+void cache_writeback(cache_layer_t* cache, uint64_t address, uint32_t sector_mask, const memory_access_t* origin);
+// Functional-only access: same tag/replacement updates as cache_access, no statistics
+bool cache_warm(cache_layer_t* cache, memory_access_t* access);
 double get_hit_rate(cache_layer_t* cache);
 double get_miss_rate(cache_layer_t* cache);
+double get_sampling_scale(cache_layer_t* cache); // Observed over simulated accesses
+uint32_t cache_valid_lines(const cache_layer_t* cache);
+// Lines of upper that are also resident in lower (same block size)
+uint32_t cache_duplicate_lines(const cache_layer_t* upper, const cache_layer_t* lower);
 void print_cache_stats(cache_layer_t* cache);
 void cache_layer_free(cache_layer_t* cache);
 
@@ -0,0 +1,29 @@
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include "gpu_memory_system.h"
+
+// --- Binary Checkpoint Format ---
+// Header (magic, version, trace offset, system counters), the shared memory scratchpad
+// (counters, conflict histogram and open warp requests), the DRAM (counters, open rows and
+// bank/bus busy times), address translation counters, then one section per cache layer (L1, L2
+// and, when translating, the per-SM L1 TLBs, the L2 TLB and the page-walk cache):
+// geometry, inclusion mode, write policy and slicing, counters (prefetch, traffic, inclusion,
+// write and per-slice counters), RRIP selector/throttle, SHiP counter table, fast-path
+// memo and prefetcher type/degree/training tables, way partitioning (quotas, counters and utility monitors), the victim cache (counters
+// and lines in recency order), then per simulated set the LRU clock, RRIP/SHiP state, FIFO order and the
+// tag/flags/access_time/access_count/sector masks/signature/owner of every way, and finally the
+// layer's shadow-tag monitors, each saved as a layer section of its own.
+// Simulated data bytes are not saved.
+#define CHECKPOINT_MAGIC 0x4B435347u // "GSCK"
+#define CHECKPOINT_VERSION 19
+
+// Writes the full hierarchy state; trace_offset is the index of the next trace entry to simulate.
+// The file is written to "<path>.tmp" first and renamed, so a crash never leaves a torn checkpoint.
+int checkpoint_save(const char* path, gpu_memory_system_t* system, uint64_t trace_offset);
+
+// Restores into a system created with the same configuration (geometry is validated).
+// The file is mmap'ed and decoded in place.
+int checkpoint_restore(const char* path, gpu_memory_system_t* system, uint64_t* trace_offset);
+
+#endif // CHECKPOINT_H
@@ -0,0 +1,108 @@
+#ifndef DRAM_H
+#define DRAM_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// --- DRAM Timing Model (global memory behind the L2) ---
+// Channels of independent banks with open-page row buffers. A request to the open row costs
+// tCAS, to a precharged bank tRCD + tCAS, and to a bank holding another row tRP + tRCD + tCAS;
+// data then occupies the channel bus for bytes / bus_bytes cycles. t_base covers the controller
+// and interconnect round trip. All times are core cycles.
+//
+// Serialized simulation calls dram_read directly. The event-driven engine queues reads per
+// channel and lets dram_schedule pick among them FR-FCFS: the oldest row hit first, else the
+// oldest request (with a starvation cap). Writebacks are posted with dram_write.
+
+#define DRAM_DEFAULT_CHANNELS 8
+#define DRAM_DEFAULT_BANKS 16
+#define DRAM_DEFAULT_ROW_SIZE 2048   // Bytes per row (per bank)
+#define DRAM_DEFAULT_BUS_BYTES 16    // Channel bytes per core cycle
+#define DRAM_DEFAULT_T_BASE 330
+#define DRAM_DEFAULT_T_CAS 24
+#define DRAM_DEFAULT_T_RCD 24
+#define DRAM_DEFAULT_T_RP 24
+#define DRAM_STARVATION_CYCLES 2000  // Oldest request wins once it has waited this long
+
+// Physical address -> (channel, bank, row) interleaving, low to high address bits
+typedef enum {
+    DRAM_MAP_LINE, // line | channel | column | bank | row: consecutive lines spread over channels
+    DRAM_MAP_ROW,  // line | column | channel | bank | row: a whole row stays in one channel
+    DRAM_MAP_XOR   // As DRAM_MAP_LINE, bank XORed with the low row bits to spread conflicts
+} dram_mapping_t;
+
+typedef struct {
+    uint32_t channels;
+    uint32_t banks;      // Per channel
+    uint32_t row_size;
+    uint32_t bus_bytes;
+    uint32_t t_base;
+    uint32_t t_cas;
+    uint32_t t_rcd;
+    uint32_t t_rp;
+    dram_mapping_t mapping;
+} dram_config_t;
+
+typedef struct {
+    bool open;
+    uint64_t row;
+    uint64_t ready; // Cycle the bank can take its next command
+} dram_bank_t;
+
+typedef struct {
+    uint64_t arrival;
+    uint64_t row;
+    uint32_t bank;
+    uint32_t bytes;
+    uint32_t tag;   // Caller's handle, returned by dram_schedule
+} dram_request_t;
+
+typedef struct {
+    dram_bank_t* banks;
+    uint64_t bus_ready;
+
+    dram_request_t* queue; // Pending reads (event-driven engine only)
+    uint32_t queued;
+    uint32_t queue_capacity;
+
+    uint64_t requests;
+    uint64_t bus_cycles;   // Cycles the data bus was transferring
+} dram_channel_t;
+
+typedef struct dram_t {
+    dram_config_t config;
+    dram_channel_t* channels;
+
+    uint64_t reads;
+    uint64_t writes;
+    uint64_t bytes;
+    uint64_t row_hits;
+    uint64_t row_misses;    // Bank precharged, row had to be opened
+    uint64_t row_conflicts; // Another row open, precharge first
+    uint64_t read_latency;  // Sum of arrival-to-data cycles over reads
+    uint64_t queue_cycles;  // Sum of cycles reads waited before their first command
+} dram_t;
+
+void dram_config_default(dram_config_t* config);
+int dram_parse_mapping(const char* name, dram_mapping_t* mapping);
+const char* dram_mapping_name(dram_mapping_t mapping);
+
+dram_t* dram_create(const dram_config_t* config);
+// Read issued at cycle now with nothing else queued; returns the cycle the data reaches the L2
+uint64_t dram_read(dram_t* dram, uint64_t address, uint32_t bytes, uint64_t now);
+// Posted write (writeback): occupies its bank and the bus, nobody waits for it
+void dram_write(dram_t* dram, uint64_t address, uint32_t bytes, uint64_t now);
+
+// Queues a read for FR-FCFS scheduling; returns its channel
+int dram_enqueue(dram_t* dram, uint64_t address, uint32_t bytes, uint64_t arrival, uint32_t tag);
+// Issues at most one queued read of channel at cycle now; false if none can start yet
+bool dram_schedule(dram_t* dram, uint32_t channel, uint64_t now, uint32_t* tag, uint64_t* done);
+// Earliest cycle a queued read of channel could start, UINT64_MAX if none is queued
+uint64_t dram_next_decision(dram_t* dram, uint32_t channel);
+
+void dram_print_stats(dram_t* dram, uint64_t elapsed_cycles);
+// All banks precharged and idle, queues empty, counters zeroed (queue storage is kept)
+void dram_reset(dram_t* dram);
+void dram_free(dram_t* dram);
+
+#endif // DRAM_H
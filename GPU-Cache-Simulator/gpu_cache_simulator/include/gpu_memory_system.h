@@ -2,16 +2,64 @@
 #define GPU_MEMORY_SYSTEM_H
 
 #include "cache_layer.h"
+#include "scratchpad.h"
+#include "dram.h"
+#include "mmu.h"
 #include "utils.h"
+#include "line_trace.h"
 
 // --- Configuration Parameters ---
 #define NUM_REGISTERS_PER_THREAD 256 // Each register is 4 bytes
-#define SHARED_MEMORY_SIZE (64 * 1024) // 64KB (Direct-mapped cache logic used)
+#define SHARED_MEMORY_SIZE (64 * 1024) // 64KB per thread block (banked scratchpad)
+#define SHARED_MEMORY_LATENCY 20
 #define L1_CACHE_SIZE (64 * 1024)      // 64KB
 #define L1_ASSOCIATIVITY 4
 #define L2_CACHE_SIZE (4 * 1024 * 1024)  // 4MB
 #define L2_ASSOCIATIVITY 16
 #define GLOBAL_MEMORY_SIZE (1024ULL * 1024 * 1024) // 1GB
+#define GLOBAL_MEMORY_LATENCY 400 // Nominal cycles per L2 miss (DRAM model off the critical path)
+
+// Level of the hierarchy that serviced the most recent gpu_memory_access
+typedef enum {
+    MEM_LEVEL_REGISTER,
+    MEM_LEVEL_SHARED,
+    MEM_LEVEL_L1,
+    MEM_LEVEL_L2,
+    MEM_LEVEL_GLOBAL
+} mem_level_t;
+
+// --- Hierarchy Configuration (defaults match the constants above) ---
+typedef struct {
+    replacement_policy_t l1_policy;
+    replacement_policy_t l2_policy;
+    uint32_t l2_size;
+    uint32_t l2_associativity;
+    set_sampling_t l2_set_sampling; // Approximate L2 by simulating a subset of its sets
+    uint32_t l2_sample_ratio;
+    uint32_t l2_slices;             // Independent L2 slices, 1 = monolithic
+    slice_hash_t l2_slice_hash;     // Line address -> slice
+    prefetcher_type_t l1_prefetcher;
+    uint32_t l1_prefetch_degree;
+    prefetcher_type_t l2_prefetcher;
+    uint32_t l2_prefetch_degree;
+    uint32_t sector_size; // L1/L2 sector bytes, 0 = whole-line transfers
+    inclusion_policy_t inclusion; // L2 contents relative to the L1
+    write_hit_policy_t l1_write_hit;    // Default write-through: stores update L1 and the L2
+    write_miss_policy_t l1_write_miss;  // Default no-allocate: store misses bypass the L1
+    write_hit_policy_t l2_write_hit;
+    write_miss_policy_t l2_write_miss;
+    uint32_t l2_shadows;            // What-if shadow-tag configurations on the L2
+    replacement_policy_t l2_shadow_policy[CACHE_MAX_SHADOWS - 1];
+    uint32_t l2_shadow_ways[CACHE_MAX_SHADOWS - 1];
+    uint32_t l2_partitions;         // Way-partitioned L2, 0 = shared
+    partition_key_t l2_partition_key;
+    uint32_t l2_partition_ways[PARTITION_MAX]; // Static split, used when l2_partition_split
+    bool l2_partition_split;        // A split was given; otherwise the ways are divided equally
+    uint32_t l2_ucp_interval;       // Utility-based repartitioning period, 0 = static
+    uint32_t l1_victim_entries;     // Victim cache between L1 and L2, 0 = none
+    dram_config_t dram;
+    mmu_config_t mmu;               // Address translation in front of the L1 (off by default)
+} gpu_system_config_t;
 
 // --- GPU System Structure ---
 typedef struct {
@@ -19,8 +67,12 @@ typedef struct {
     uint32_t* register_files[MAX_THREADS]; // Simulated per-thread registers
     uint64_t register_hits;
 
+    // Address translation (NULL = addresses are used untranslated)
+    mmu_t* mmu;
+    uint32_t last_translation; // Cycles the last access spent translating
+
     // Cache Hierarchy
-    cache_layer_t* shared_memory; // L1 Shared Memory (used as Direct-Mapped cache)
+    scratchpad_t* shared_memory;  // Per-thread-block banked scratchpad
     cache_layer_t* l1_cache;      // L1 Cache (Per-SM)
     cache_layer_t* l2_cache;      // L2 Cache (Global)
 
@@ -28,15 +80,37 @@ typedef struct {
     uint8_t* global_memory; // 1GB of simulated global memory
     uint64_t global_memory_size;
     uint64_t global_memory_accesses;
+    dram_t* dram;    // Timing of L2 misses and writebacks
+    bool defer_dram; // Set by the event-driven engine, which queues L2 misses to the DRAM itself
 
     // Statistics
     uint64_t total_accesses;
-    uint32_t current_cycle;
+    uint64_t total_latency;  // Sum of per-access latencies (AMAT numerator)
+    uint64_t current_cycle;  // Simulated time; equals total_latency when accesses are serialized
+    mem_level_t last_level;  // Where the last access was serviced
+
+    // L2 set sampling: L1 misses to unsimulated L2 sets are charged the mean latency below the
+    // L1 of the simulated ones, so AMAT and cycles become estimates
+    uint64_t l2_sampled_cycles;
+    uint64_t l2_sampled_misses;
+    uint64_t l2_estimated_accesses;
 } gpu_memory_system_t;
 
 // --- Functions ---
+void gpu_system_config_default(gpu_system_config_t* config);
+// Applies one hierarchy option ("--l2-size", "4096", ...): 0 if applied, 1 if option is not a
+// hierarchy option, -1 if its value is invalid
+int gpu_system_config_parse_option(gpu_system_config_t* config, const char* option, const char* value);
 gpu_memory_system_t* create_gpu_memory_system(void);
+gpu_memory_system_t* create_gpu_memory_system_with_config(const gpu_system_config_t* config);
 uint32_t gpu_memory_access(gpu_memory_system_t* system, memory_access_t* access);
+// Functional fast-forward: warms caches without statistics or latency accounting
+void gpu_memory_warm(gpu_memory_system_t* system, memory_access_t* access);
+// Returns the system to its freshly created state in place (no reallocation), for reuse across runs
+void gpu_memory_system_reset(gpu_memory_system_t* system);
+// Line-ID fast path in the L1 and L2 for accesses built from trace (NULL unbinds); layers whose
+// line size differs keep decomposing addresses
+void gpu_memory_system_bind_line_trace(gpu_memory_system_t* system, const line_trace_t* trace);
 void print_gpu_system_stats(gpu_memory_system_t* system);
 void free_gpu_memory_system(gpu_memory_system_t* system);
 
@@ -0,0 +1,62 @@
+#ifndef LINE_TRACE_H
+#define LINE_TRACE_H
+
+#include "utils.h"
+
+// --- Line-ID Traces ---
+// A trace preprocessed once for repeated runs (`--make-line-trace`): every distinct cache line
+// gets a dense 32-bit ID, 1, 2, ... in first-touch order (0 means "no ID"), and each access
+// shrinks to a 12-byte record. The records go to <path>, the dictionary (line address, accesses
+// and writes per ID) to the sidecar <path>.dict, both in native byte order like checkpoints.
+// Addresses are recovered exactly from the line address and the record's offset. Thread and
+// block IDs are stored reduced modulo MAX_THREADS/MAX_BLOCKS, as the simulation uses them, and
+// the request size (unused by the simulation) is dropped.
+#define LINE_TRACE_MAGIC 0x4C544753u // "SGTL"
+#define LINE_TRACE_VERSION 1
+#define LINE_TRACE_LINE_SIZE CACHE_LINE_SIZE // At most 128: offsets take 7 bits
+#define LINE_TRACE_DICT_SUFFIX ".dict"
+#define LINE_TRACE_WRITE 0x80u       // Record flag in offset
+#define LINE_TRACE_OFFSET_MASK 0x7Fu
+
+typedef struct {
+    uint32_t line_id;
+    uint16_t thread_id;
+    uint8_t block_id;
+    uint8_t offset; // Byte offset within the line, LINE_TRACE_WRITE for stores
+    uint32_t stream_id;
+} line_trace_record_t;
+
+typedef struct {
+    uint32_t line_size;
+    uint32_t count; // Records
+    line_trace_record_t* records;
+    uint32_t num_lines;      // Distinct lines; IDs are 1..num_lines
+    uint64_t* lines;         // ID -> line address (address / line_size); [0] unused
+    uint32_t* line_accesses; // ID -> accesses
+    uint32_t* line_writes;   // ID -> stores
+} line_trace_t;
+
+// Assigns line IDs to a parsed trace
+line_trace_t* line_trace_build(const memory_trace_t* traces, uint32_t count);
+// Writes path and path.dict
+int line_trace_save(const line_trace_t* trace, const char* path);
+line_trace_t* line_trace_load(const char* path);
+// True if path starts like a line trace (as opposed to a text trace)
+bool line_trace_is_file(const char* path);
+// Full records again, for code that works on memory_trace_t (free with free_memory_trace)
+memory_trace_t* line_trace_expand(const line_trace_t* trace);
+// The text trace summary plus footprint statistics from the dictionary
+void line_trace_print_summary(const line_trace_t* trace);
+void line_trace_free(line_trace_t* trace);
+
+static inline void line_trace_access(const line_trace_t* trace, uint32_t index, memory_access_t* access) {
+    const line_trace_record_t* rec = &trace->records[index];
+    access->address = trace->lines[rec->line_id] * trace->line_size + (rec->offset & LINE_TRACE_OFFSET_MASK);
+    access->type = (rec->offset & LINE_TRACE_WRITE) ? ACCESS_WRITE : ACCESS_READ;
+    access->thread_id = rec->thread_id;
+    access->block_id = rec->block_id;
+    access->stream_id = rec->stream_id;
+    access->line_id = rec->line_id;
+}
+
+#endif // LINE_TRACE_H
@@ -0,0 +1,51 @@
+#ifndef MISS_STREAM_H
+#define MISS_STREAM_H
+
+#include <stdio.h>
+#include "utils.h"
+
+struct cache_layer_t;
+
+// --- Miss Stream ---
+// The filtered request stream leaving a cache layer (demand misses plus dirty writebacks),
+// stored as fixed 12-byte little-endian records after an 8-byte header:
+//   u64 address | u16 thread_id | u8 block_id | u8 kind (bits 0-1) and stream_id mod 64 (bits 2-7)
+#define MISS_STREAM_MAGIC 0x4D535347u // "GSSM"
+#define MISS_STREAM_VERSION 2
+#define MISS_STREAM_RECORD_SIZE 12
+
+typedef enum {
+    MISS_RECORD_READ,      // Demand read miss
+    MISS_RECORD_WRITE,     // Demand write miss
+    MISS_RECORD_WRITEBACK  // Dirty line evicted from the layer (line-aligned address)
+} miss_record_kind_t;
+
+typedef struct miss_stream_t {
+    FILE* file;
+    uint64_t records;
+    uint64_t writebacks;
+} miss_stream_t;
+
+// Several layers may share one stream; records are appended in simulation order
+miss_stream_t* miss_stream_open(const char* path);
+void miss_stream_record(miss_stream_t* stream, uint64_t address, miss_record_kind_t kind,
+                        const memory_access_t* origin);
+void miss_stream_close(miss_stream_t* stream);
+
+typedef struct {
+    uint64_t records;
+    uint64_t demand;     // Read/write misses fed to the target layer
+    uint64_t writebacks; // Writeback records seen
+} miss_replay_stats_t;
+
+// Feeds a captured stream straight into target (normally the L2), reproducing the requests
+// the upper levels sent it during the original run.
+int miss_stream_replay(const char* path, struct cache_layer_t* target, miss_replay_stats_t* stats);
+
+// Same result as miss_stream_replay on a sliced target (see cache_layer_fork), with the slices
+// spread over up to threads worker threads. Only the memo fast-path hit count can differ.
+#define MISS_REPLAY_MAX_THREADS 64
+int miss_stream_replay_parallel(const char* path, struct cache_layer_t* target, uint32_t threads,
+                                miss_replay_stats_t* stats);
+
+#endif // MISS_STREAM_H
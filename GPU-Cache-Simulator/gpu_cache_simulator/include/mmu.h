@@ -0,0 +1,90 @@
+#ifndef MMU_H
+#define MMU_H
+
+#include "cache_layer.h"
+
+// --- Address Translation ---
+// Optional stage in front of the L1: a per-SM L1 TLB (one per thread block slot, like the L1's
+// last-line memos), a shared L2 TLB, then a page walk over a four-level radix table with 9 index
+// bits per level above the 4KB offset. A 2MB page is a level-3 leaf; a 64KB page is a level-4
+// leaf of a big-page table, so it walks as deep as a 4KB page but each entry covers 16x more.
+// A page-walk cache holds the upper-level entries (levels 1-3); the walk reads the levels below
+// the deepest one it hits, walk_latency cycles each. Translation is the identity, only its cost
+// and the TLB contents are modelled.
+//
+// TLBs and the walk cache are cache layers with 1-byte lines whose "address" is a key holding the
+// page (or table) number in the low bits, which pick the set, and its size class (or level) in
+// the top two, so pages of different sizes share every set.
+// The page size of an address comes from the region table, else the default.
+
+#define MMU_MAX_REGIONS 8
+#define MMU_WALK_LEVELS 4
+#define MMU_DEFAULT_L1_TLB_ENTRIES 32   // Fully associative
+#define MMU_DEFAULT_L1_TLB_LATENCY 1
+#define MMU_DEFAULT_L2_TLB_ENTRIES 1024
+#define MMU_DEFAULT_L2_TLB_WAYS 16
+#define MMU_DEFAULT_L2_TLB_LATENCY 20
+#define MMU_DEFAULT_PWC_ENTRIES 64      // Fully associative
+#define MMU_DEFAULT_PWC_LATENCY 10
+#define MMU_DEFAULT_WALK_LATENCY 200    // Per page-table level read (an L2 hit)
+
+typedef enum {
+    PAGE_4K,
+    PAGE_64K,
+    PAGE_2M,
+    PAGE_SIZE_CLASSES
+} page_size_t;
+
+typedef struct {
+    uint64_t start;
+    uint64_t end;   // Exclusive
+    page_size_t page_size;
+} mmu_region_t;
+
+typedef struct {
+    bool enabled;
+    page_size_t page_size;          // Outside every region
+    mmu_region_t regions[MMU_MAX_REGIONS];
+    uint32_t num_regions;
+    uint32_t l1_tlb_entries;
+    uint32_t l1_tlb_ways;           // 0 = fully associative
+    uint32_t l2_tlb_entries;
+    uint32_t l2_tlb_ways;
+    uint32_t pwc_entries;           // 0 = no page-walk cache
+    uint32_t walk_latency;
+} mmu_config_t;
+
+typedef struct mmu_t {
+    mmu_config_t config;
+    cache_layer_t* l1_tlbs[MAX_BLOCKS];
+    cache_layer_t* l2_tlb;
+    cache_layer_t* pwc;
+
+    uint64_t translations;
+    uint64_t page_translations[PAGE_SIZE_CLASSES];
+    uint64_t walks;
+    uint64_t walk_reads;       // Page-table levels read
+    uint64_t walk_cycles;
+    uint64_t translation_cycles;
+} mmu_t;
+
+void mmu_config_default(mmu_config_t* config);
+// Parses "4K", "64K" or "2M"
+int mmu_parse_page_size(const char* name, page_size_t* page_size);
+const char* mmu_page_size_name(page_size_t page_size);
+// Parses "<page>:<start>:<end>" and appends it to the region table
+int mmu_parse_region(const char* spec, mmu_config_t* config);
+// Parses "<entries>[:ways]" (ways 0 = fully associative)
+int mmu_parse_tlb(const char* spec, uint32_t* entries, uint32_t* ways);
+
+mmu_t* mmu_create(const mmu_config_t* config);
+// Translates access->address; returns the cycles spent before the L1 can be accessed
+uint32_t mmu_translate(mmu_t* mmu, const memory_access_t* access);
+// Functional warm-up: TLB and walk cache contents only
+void mmu_warm(mmu_t* mmu, const memory_access_t* access);
+void mmu_print_stats(const mmu_t* mmu);
+// Empty TLBs and walk cache, counters zeroed
+void mmu_reset(mmu_t* mmu);
+void mmu_free(mmu_t* mmu);
+
+#endif // MMU_H
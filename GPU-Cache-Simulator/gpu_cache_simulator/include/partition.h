@@ -0,0 +1,65 @@
+#ifndef PARTITION_H
+#define PARTITION_H
+
+#include "utils.h"
+
+// --- Way Partitioning of a Shared Cache ---
+// Accesses are assigned to one of up to PARTITION_MAX partitions by thread block or by trace
+// stream (key value mod partition count). Each partition owns a contiguous range of ways: its
+// fills may only replace lines in those ways, while hits are found in any way. With a UCP
+// interval set, per-partition utility monitors (LRU stack-distance histograms over a strided
+// 1/UMON_SAMPLE_RATIO of the sets) drive a lookahead reallocation of the ways every interval
+// accesses; lines stay in place until their new owner's fills evict them.
+
+#define PARTITION_MAX 8
+#define PARTITION_MAX_WAYS 64    // Way masks are 64-bit
+#define UMON_SAMPLE_RATIO 32
+#define UCP_DEFAULT_INTERVAL 50000
+
+typedef enum {
+    PARTITION_BY_BLOCK,
+    PARTITION_BY_STREAM
+} partition_key_t;
+
+typedef struct partition_t {
+    partition_key_t key;
+    uint32_t count;
+    uint32_t associativity;
+    uint32_t ways[PARTITION_MAX];   // Current quota
+    uint32_t initial_ways[PARTITION_MAX]; // Quota at creation
+    uint64_t masks[PARTITION_MAX];  // Ways each partition may fill
+    uint64_t hits[PARTITION_MAX];
+    uint64_t misses[PARTITION_MAX];
+
+    // Utility-based repartitioning (interval 0 = static quotas)
+    uint32_t interval;
+    uint64_t since_repartition;
+    uint64_t repartitions;
+    uint32_t num_sets;       // Of the partitioned cache
+    uint32_t umon_sets;      // Sets monitored (every UMON_SAMPLE_RATIO-th)
+    uint64_t* umon_tags;     // [partition][umon set][stack position], tag + 1, 0 = empty
+    uint64_t* umon_hits;     // [partition][stack position]
+} partition_t;
+
+// ways may be NULL for an equal split; the quotas must cover associativity with at least one way each
+partition_t* partition_create(partition_key_t key, uint32_t count, const uint32_t* ways,
+                              uint32_t associativity, uint32_t num_sets, uint32_t interval);
+// Parses "<block|stream>:<n>[:w0,w1,...]"; has_split tells whether ways[] was given (else zeroed)
+int partition_parse(const char* spec, partition_key_t* key, uint32_t* count, uint32_t* ways, bool* has_split);
+const char* partition_key_name(partition_key_t key);
+
+static inline uint32_t partition_of(const partition_t* part, const memory_access_t* access) {
+    return (part->key == PARTITION_BY_STREAM ? access->stream_id : access->block_id) % part->count;
+}
+
+// Recomputes the way masks from the quotas: contiguous ranges in partition order
+void partition_build_masks(partition_t* part);
+// Demand access outcome: statistics, utility monitor and, every interval accesses, repartitioning
+void partition_observe(partition_t* part, const memory_access_t* access, uint64_t block_addr, bool hit);
+// occupancy[p] = valid lines currently owned by partition p, out of total_lines
+void partition_print_stats(const partition_t* part, const uint32_t* occupancy, uint32_t total_lines);
+// Back to the initial quotas with counters and utility monitors cleared
+void partition_reset(partition_t* part);
+void partition_free(partition_t* part);
+
+#endif // PARTITION_H
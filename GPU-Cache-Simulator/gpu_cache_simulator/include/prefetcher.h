@@ -0,0 +1,52 @@
+#ifndef PREFETCHER_H
+#define PREFETCHER_H
+
+#include "utils.h"
+#include <stddef.h>
+
+// --- Hardware Prefetchers ---
+// A prefetcher observes the demand accesses of one cache layer and proposes block addresses
+// (address / block_size) to fill; the layer performs the fills (see cache_access).
+
+#define PREFETCH_DEFAULT_DEGREE 2
+#define PREFETCH_MAX_DEGREE 16
+#define STRIDE_TABLE_BITS 12    // Reference prediction table of 4096 entries
+#define STRIDE_TABLE_SIZE (1u << STRIDE_TABLE_BITS)
+#define STREAM_TABLE_SIZE 16    // Concurrently tracked streams
+#define STREAM_WINDOW 8         // Blocks a miss may be from a stream head and still extend it
+
+typedef enum {
+    PREFETCH_NONE,
+    PREFETCH_NEXT_LINE, // Next blocks on a miss or on the first hit to a prefetched block
+    PREFETCH_STRIDE,    // Per-thread reference prediction table
+    PREFETCH_STREAM     // Ascending/descending miss streams
+} prefetcher_type_t;
+
+// One demand access as seen by the prefetcher
+typedef struct {
+    const memory_access_t* access;
+    uint64_t block_addr;
+    bool hit;
+    bool prefetch_hit; // Hit on a block brought in by a prefetch, first demand touch
+} prefetch_event_t;
+
+typedef struct prefetcher_t {
+    prefetcher_type_t type;
+    uint32_t degree;
+    void* state;
+
+    // Writes up to max candidate block addresses for event into out, returns how many
+    uint32_t (*observe)(struct prefetcher_t* pf, const prefetch_event_t* event, uint64_t* out, uint32_t max);
+} prefetcher_t;
+
+// "next-line", "stride" or "stream", optionally followed by ":<degree>"
+int prefetcher_parse(const char* spec, prefetcher_type_t* type, uint32_t* degree);
+const char* prefetcher_name(prefetcher_type_t type);
+prefetcher_t* prefetcher_create(prefetcher_type_t type, uint32_t degree);
+// Forgets everything learned (empty tables)
+void prefetcher_reset(prefetcher_t* pf);
+// Bytes of the fixed-size training state at pf->state (0 for next-line), saved by checkpoints
+size_t prefetcher_state_size(const prefetcher_t* pf);
+void prefetcher_free(prefetcher_t* pf);
+
+#endif // PREFETCHER_H
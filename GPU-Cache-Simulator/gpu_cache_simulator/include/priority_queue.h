@@ -19,7 +19,12 @@ priority_queue_t* pq_create(uint32_t capacity);
 void pq_insert(priority_queue_t* pq, uint32_t data, uint32_t priority);
 uint32_t pq_extract_min(priority_queue_t* pq);
 uint32_t pq_peek_min(priority_queue_t* pq);
+uint32_t pq_peek_min_priority(priority_queue_t* pq);
 bool pq_is_empty(priority_queue_t* pq);
+// Doubles the capacity; returns -1 (queue unchanged) if out of memory
+int pq_grow(priority_queue_t* pq);
+// Subtracts delta from every priority; all must be >= delta, so the heap order is kept
+void pq_rebase(priority_queue_t* pq, uint32_t delta);
 void pq_free(priority_queue_t* pq);
 
 #endif // PRIORITY_QUEUE_H
@@ -0,0 +1,52 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <stdint.h>
+
+// --- Hot-Path Phase Profiler ---
+// Build with `make PROFILE=1` (defines GPU_SIM_PROFILE) to enable. When disabled
+// every PROF_* macro expands to nothing, so the hot path carries no overhead.
+
+typedef enum {
+    PROF_TRACE_PARSE,        // sscanf of one trace line (utils.c)
+    PROF_GPU_ACCESS,         // Whole gpu_memory_access call
+    PROF_REGION_CHECK,       // Register / shared memory address classification
+    PROF_FAST_PATH,          // Block address + last-line memo check
+    PROF_ADDR_DECOMPOSE,     // Set index / tag computation
+    PROF_TAG_LOOKUP,         // Set scan for a matching tag
+    PROF_VICTIM_SELECT,      // find_victim_block
+    PROF_REPLACEMENT_UPDATE, // LRU/LFU/FIFO metadata and block install
+    PROF_NEXT_LEVEL,         // Recursive cache_access on the next level (inclusive)
+    PROF_NUM_PHASES
+} prof_phase_t;
+
+extern uint64_t profiler_cycles[PROF_NUM_PHASES];
+extern uint64_t profiler_calls[PROF_NUM_PHASES];
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+static inline uint64_t profiler_now(void) { return __rdtsc(); }
+#define PROFILER_UNIT "cycles"
+#else
+uint64_t profiler_now(void); // clock_gettime(CLOCK_MONOTONIC) in nanoseconds
+#define PROFILER_UNIT "ns"
+#endif
+
+void profiler_reset(void);
+void profiler_print_report(void);
+
+#ifdef GPU_SIM_PROFILE
+// Scoped timer: PROF_BEGIN and PROF_END must appear in the same block.
+#define PROF_BEGIN(phase) uint64_t prof_start_##phase = profiler_now()
+#define PROF_END(phase) do { \
+        profiler_cycles[phase] += profiler_now() - prof_start_##phase; \
+        profiler_calls[phase]++; \
+    } while (0)
+#define PROF_REPORT() profiler_print_report()
+#else
+#define PROF_BEGIN(phase) ((void)0)
+#define PROF_END(phase) ((void)0)
+#define PROF_REPORT() ((void)0)
+#endif
+
+#endif // PROFILER_H
@@ -18,6 +18,7 @@ typedef struct {
 queue_t* queue_create(void);
 void queue_enqueue(queue_t* q, uint32_t data);
 uint32_t queue_dequeue(queue_t* q);
+bool queue_remove(queue_t* q, uint32_t data); // First node holding data; false if none
 bool queue_is_empty(queue_t* q);
 void queue_free(queue_t* q);
 
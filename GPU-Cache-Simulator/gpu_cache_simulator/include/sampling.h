@@ -0,0 +1,63 @@
+#ifndef SAMPLING_H
+#define SAMPLING_H
+
+#include "gpu_memory_system.h"
+
+// --- Sampled Simulation ---
+// The trace is split into repeating periods of fast-forward, warmup and measure intervals.
+// Fast-forward only warms tags (or skips entirely), warmup runs the full access path without
+// contributing to the estimates, and each measure window yields one sample of every metric.
+
+typedef enum {
+    SAMPLE_PHASE_FAST_FORWARD,
+    SAMPLE_PHASE_WARMUP,
+    SAMPLE_PHASE_MEASURE
+} sample_phase_t;
+
+typedef struct {
+    uint64_t fast_forward; // Accesses per period
+    uint64_t warmup;
+    uint64_t measure;
+    bool skip;             // Fast-forward drops accesses instead of functionally warming
+} sampling_config_t;
+
+// Welford running mean/variance
+typedef struct {
+    uint64_t n;
+    double mean;
+    double m2;
+} running_stat_t;
+
+typedef struct {
+    uint64_t accesses;
+    uint64_t cycles;
+    uint64_t l1_hits, l1_misses;
+    uint64_t l2_hits, l2_misses;
+    uint64_t global_accesses;
+} gpu_stats_snapshot_t;
+
+typedef struct {
+    sampling_config_t config;
+    uint64_t position;            // Accesses seen so far
+    bool in_window;
+    gpu_stats_snapshot_t window_start;
+
+    uint64_t fast_forwarded, warmed, measured;
+    running_stat_t amat;          // Cycles per access
+    running_stat_t l1_hit_rate;   // Percent
+    running_stat_t l2_hit_rate;   // Percent
+    running_stat_t global_rate;   // Global memory accesses per access
+} sampler_t;
+
+// Parses "FF:WARMUP:MEASURE[:skip]", e.g. "90000:5000:5000"
+int sampling_parse(const char* spec, sampling_config_t* config);
+
+void sampler_init(sampler_t* sampler, const sampling_config_t* config);
+// Call once before every access; returns how that access must be simulated
+sample_phase_t sampler_next_phase(sampler_t* sampler, gpu_memory_system_t* system);
+// Closes a measure window left open at the end of the trace
+void sampler_finish(sampler_t* sampler, gpu_memory_system_t* system);
+// Prints estimates with 95% confidence intervals, extrapolated to total_accesses
+void sampler_print_report(sampler_t* sampler, uint64_t total_accesses);
+
+#endif // SAMPLING_H
@@ -0,0 +1,56 @@
+#ifndef SCRATCHPAD_H
+#define SCRATCHPAD_H
+
+#include "utils.h"
+
+// --- Banked Shared Memory (Scratchpad) ---
+// Each thread block owns a scratchpad of SHARED_MEMORY_SIZE bytes interleaved over 32 banks of
+// 4-byte words. Consecutive trace entries from the same warp and of the same operation form one
+// warp request (a lane repeating starts a new one). Lanes that hit different words of the same
+// bank serialize; lanes reading the same word are served by one broadcast.
+
+#define SCRATCHPAD_BANKS 32
+#define SCRATCHPAD_BANK_WIDTH 4   // Bytes per bank word
+#define SCRATCHPAD_WARP_SIZE 32
+#define SCRATCHPAD_REPLAY_CYCLES 2 // Extra cycles per additional serialized bank pass
+
+// Warp request being assembled for one thread block
+typedef struct {
+    bool open;
+    uint32_t warp;
+    access_type_t type;
+    uint32_t lanes;                         // Bitmask of lanes already in the request
+    uint32_t num_words;
+    uint64_t words[SCRATCHPAD_WARP_SIZE];   // Distinct words referenced
+    uint8_t word_pass[SCRATCHPAD_WARP_SIZE]; // Pass in which each word is read
+    uint8_t bank_words[SCRATCHPAD_BANKS];   // Distinct words per bank
+    uint32_t degree;                        // Max of bank_words (passes needed)
+} scratchpad_request_t;
+
+typedef struct {
+    char name[48];
+    uint32_t size;      // Bytes per thread block
+    uint32_t latency;   // Conflict-free access latency
+
+    scratchpad_request_t pending[MAX_BLOCKS];
+
+    uint64_t accesses;
+    uint64_t requests;
+    uint64_t broadcasts;        // Lanes served by a word another lane already fetched
+    uint64_t conflict_cycles;   // Extra passes of all requests times SCRATCHPAD_REPLAY_CYCLES
+    uint64_t degree_sum;        // Sum of closed requests' conflict degrees
+    uint64_t histogram[SCRATCHPAD_BANKS + 1]; // Closed requests by conflict degree (1..32)
+} scratchpad_t;
+
+scratchpad_t* scratchpad_create(const char* name, uint32_t size, uint32_t latency);
+// Latency of one lane's access: the scratchpad latency plus the passes its warp request
+// needed before serving this lane's bank
+uint32_t scratchpad_access(scratchpad_t* sp, const memory_access_t* access, uint32_t offset);
+// Closes all open warp requests so they appear in the histogram
+void scratchpad_flush(scratchpad_t* sp);
+void scratchpad_print_stats(scratchpad_t* sp);
+// Drops open warp requests and zeroes the counters
+void scratchpad_reset(scratchpad_t* sp);
+void scratchpad_free(scratchpad_t* sp);
+
+#endif // SCRATCHPAD_H
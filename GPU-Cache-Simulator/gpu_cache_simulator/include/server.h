@@ -0,0 +1,40 @@
+#ifndef SERVER_H
+#define SERVER_H
+
+#include "gpu_memory_system.h"
+
+// --- Simulation Server ---
+// `--serve <socket>` keeps the simulator running as a daemon on a Unix domain stream socket.
+// Clients send newline-terminated requests and get one single-line JSON object back per request.
+// A connection may pipeline any number of requests; each connection is served by one worker.
+//
+//   run <trace> [hierarchy options]  Simulate a trace and return its statistics. <trace> is a
+//                                    trace file or shm:<name>, a POSIX shared-memory object
+//                                    holding native memory_trace_t records. The options are the
+//                                    command line's hierarchy options (--l2-size 1024 ...),
+//                                    applied on top of the configuration the server started with.
+//   status                           Workers, jobs served and cached traces
+//   shutdown                         Stop accepting work and exit once running jobs are answered
+//
+// A worker keeps the gpu_memory_system_t of its previous job and resets it in place when the
+// next job has the same configuration, so a job allocates nothing. Parsed trace files are shared
+// between workers through a small cache keyed by path, size and modification time.
+// Requests are split on whitespace, so paths cannot contain spaces.
+
+#define SERVER_DEFAULT_WORKERS 4
+#define SERVER_MAX_WORKERS 64
+#define SERVER_MAX_PENDING 256     // Accepted connections waiting for a worker
+#define SERVER_MAX_REQUEST 4096    // Bytes per request line
+#define SERVER_MAX_JOB_ARGS 64
+#define SERVER_TRACE_CACHE_SIZE 16 // Parsed trace files kept
+
+typedef struct {
+    const char* socket_path;
+    uint32_t workers;
+    gpu_system_config_t base_config; // Jobs start from this configuration
+} server_config_t;
+
+// Serves until a shutdown request; 0 after a clean shutdown, -1 if the socket cannot be set up
+int server_run(const server_config_t* config);
+
+#endif // SERVER_H
@@ -0,0 +1,98 @@
+#ifndef TIMING_ENGINE_H
+#define TIMING_ENGINE_H
+
+#include "gpu_memory_system.h"
+#include "hash_table.h"
+
+// --- Event-Driven Timing Engine ---
+// Trace entries are grouped into warps (block_id, thread_id / warp_size); each warp issues its
+// accesses in order with one access outstanding, and warps overlap freely. Cache state is
+// updated functionally at issue time through gpu_memory_access; the engine then follows the
+// access through events: L1 lookup, L1 MSHR (misses to a line already in flight merge into the
+// existing entry), L2 lookup, L2 MSHR, the DRAM channel queue (FR-FCFS, see dram.h), and the
+// fills back up through per-layer fill bandwidth. A miss that finds its MSHR table full waits in
+// FIFO order for an entry to free. Events live in a priority_queue_t keyed on cycle.
+
+#define TIMING_DEFAULT_WARP_SIZE 32
+#define TIMING_DEFAULT_ISSUE_WIDTH 4   // Accesses issued per cycle across all warps
+#define TIMING_DEFAULT_L1_MSHRS 32
+#define TIMING_DEFAULT_L2_MSHRS 128
+#define TIMING_DEFAULT_L1_BANDWIDTH 64 // Bytes per cycle, L2 -> L1
+#define TIMING_DEFAULT_L2_BANDWIDTH 32 // Bytes per cycle, DRAM -> L2
+
+typedef struct {
+    uint32_t warp_size;
+    uint32_t issue_width;
+    uint32_t l1_mshrs;
+    uint32_t l2_mshrs;
+    uint32_t l1_bandwidth; // 0 = unlimited
+    uint32_t l2_bandwidth; // 0 = unlimited
+} timing_config_t;
+
+// Outstanding-miss table of one layer; an entry is busy from allocation until its fill arrives
+typedef struct {
+    bool busy;
+    uint64_t line;
+    uint64_t address;   // Address of the allocating request (DRAM mapping)
+    uint64_t start;
+    mem_level_t level;  // Level that serviced the allocating request
+    uint32_t waiters;   // Requesters to wake on fill: warps (L1) or L1 entries (L2); free list link when idle
+} mshr_entry_t;
+
+typedef struct {
+    const char* name;
+    mshr_entry_t* entries;
+    uint32_t count;
+    uint32_t active;
+    uint32_t free_head;
+    hash_table_t* index;     // line -> busy entry
+    uint32_t wait_head;      // Requesters waiting for a free entry, oldest first
+    uint32_t wait_tail;
+
+    uint64_t allocations;
+    uint64_t merges;         // Requests that joined an in-flight miss
+    uint64_t wait_cycles;    // Cycles requesters waited for a free entry, summed over requesters
+    uint64_t full_cycles;    // Cycles with every entry busy
+    uint64_t full_since;
+    uint64_t busy_cycles;    // Sum of entry lifetimes (occupancy integral)
+    uint32_t peak_occupancy;
+} mshr_table_t;
+
+// Fill bandwidth into a layer: a calendar of per-cycle byte budgets, so transfers may be booked
+// out of order (an L2 hit can complete before an earlier DRAM fill)
+#define TIMING_PORT_HORIZON (1u << 18) // Cycles of bookings kept in the calendar ring
+
+typedef struct {
+    const char* name;
+    uint32_t bytes_per_cycle;
+    uint64_t* slot_cycle;    // Cycle each ring slot currently describes
+    uint32_t* slot_used;     // Bytes already booked in that cycle
+
+    uint64_t bytes;
+    uint64_t queue_cycles;   // Cycles transfers waited for bandwidth
+} bandwidth_port_t;
+
+typedef struct {
+    uint64_t accesses;
+    uint64_t warps;
+    uint64_t makespan;       // Cycle the last access completed
+    uint64_t total_latency;  // Sum of issue-to-completion latencies
+    uint64_t issue_stall_cycles;
+    uint64_t base_cycle;     // system->current_cycle when the run started
+
+    mshr_table_t l1_mshr;
+    mshr_table_t l2_mshr;
+    bandwidth_port_t l1_port;
+    bandwidth_port_t l2_port;
+} timing_stats_t;
+
+void timing_config_default(timing_config_t* config);
+
+// Simulates traces[begin, end) and fills stats; system->current_cycle advances by the makespan
+// and system->total_latency by the engine's issue-to-completion latencies
+int timing_run(gpu_memory_system_t* system, memory_trace_t* traces, uint32_t begin, uint32_t end,
+               const timing_config_t* config, timing_stats_t* stats);
+void timing_print_stats(const timing_stats_t* stats, const timing_config_t* config);
+void timing_stats_free(timing_stats_t* stats);
+
+#endif // TIMING_ENGINE_H
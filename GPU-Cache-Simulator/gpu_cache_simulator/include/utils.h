@@ -21,6 +21,7 @@ typedef struct {
     uint32_t size;
     uint32_t thread_id;
     uint32_t block_id;
+    uint32_t stream_id; // Optional 6th column (kernel/stream), 0 when absent
 } memory_trace_t;
 
 typedef struct {
@@ -28,6 +29,8 @@ typedef struct {
     access_type_t type;
     uint32_t thread_id;
     uint32_t block_id;
+    uint32_t stream_id;
+    uint32_t line_id; // Dense line ID from a line trace (see line_trace.h), 0 = none
 } memory_access_t;
 
 // --- Functions ---
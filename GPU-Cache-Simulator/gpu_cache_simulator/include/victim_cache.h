@@ -0,0 +1,60 @@
+#ifndef VICTIM_CACHE_H
+#define VICTIM_CACHE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "hash_table.h"
+
+// --- Victim Cache ---
+// Small fully associative buffer between a cache layer and its next level. Lines the layer
+// evicts land here; a later miss that finds its line here swaps it back instead of going to
+// the next level. Lines are found through a hash index and kept in LRU order on an intrusive
+// doubly linked list of entry indices, so lookup, insertion and replacement are O(1) at any size.
+
+#define VICTIM_CACHE_DEFAULT_LATENCY 4 // Extra cycles on top of the layer's own latency
+#define VICTIM_NONE UINT32_MAX
+
+typedef struct {
+    uint64_t line;          // Block address (address / block_size)
+    uint32_t sector_valid;
+    uint32_t sector_dirty;  // 0 = clean
+    uint32_t prev;          // Towards MRU
+    uint32_t next;          // Towards LRU (free list link when unused)
+} victim_entry_t;
+
+typedef struct victim_cache_t {
+    uint32_t capacity;
+    uint32_t latency;
+    uint32_t count;
+    victim_entry_t* entries;
+    uint32_t mru;
+    uint32_t lru;
+    uint32_t free_head;
+    hash_table_t* index;    // line -> entry
+
+    uint64_t probes;        // Misses of the layer that looked here
+    uint64_t hits;          // Probes that found the line with the requested sector
+    uint64_t partial_hits;  // Found the line, but not the requested sector
+    uint64_t inserts;
+    uint64_t evictions;     // Entries displaced to make room
+    uint64_t dirty_evictions;
+    uint64_t invalidations; // Entries removed by back-invalidation from below
+} victim_cache_t;
+
+victim_cache_t* victim_cache_create(uint32_t capacity, uint32_t latency);
+// Removes line if present, copying it to *out
+bool victim_cache_take(victim_cache_t* vc, uint64_t line, victim_entry_t* out);
+// Removes line if present (inclusive level below evicted it), returning its dirty sectors
+bool victim_cache_invalidate(victim_cache_t* vc, uint64_t line, uint32_t* sector_dirty);
+// Inserts line as MRU (merging with a copy already present). If the buffer was full, the LRU
+// entry is removed into *displaced and true is returned.
+bool victim_cache_insert(victim_cache_t* vc, uint64_t line, uint32_t sector_valid, uint32_t sector_dirty,
+                         victim_entry_t* displaced);
+// Drops every entry, counters are kept
+void victim_cache_clear(victim_cache_t* vc);
+// Drops every entry and zeroes the counters
+void victim_cache_reset(victim_cache_t* vc);
+void victim_cache_print_stats(const victim_cache_t* vc);
+void victim_cache_free(victim_cache_t* vc);
+
+#endif // VICTIM_CACHE_H
@@ -1,8 +1,11 @@
 #include "cache_layer.h"
+#include "profiler.h"
 #include <stdlib.h>
+#include <stddef.h>
 #include <string.h>
 #include <stdio.h>
 #include <math.h>
+#include <ctype.h>
 
 cache_layer_t* cache_layer_create(
     const char* name,
@@ -11,6 +14,214 @@ cache_layer_t* cache_layer_create(
     uint32_t associativity,
     replacement_policy_t policy,
     uint32_t latency
+) {
+    return cache_layer_create_sampled(name, size, block_size, associativity, policy, latency,
+        SET_SAMPLING_NONE, 1);
+}
+
+static inline bool is_rrip_policy(replacement_policy_t policy) {
+    return policy >= REPLACEMENT_SRRIP && policy <= REPLACEMENT_SHIP;
+}
+
+// Integer mix (murmur3 finalizer) used to pick a statistically unbiased subset of sets
+static uint32_t set_sample_hash(uint32_t x) {
+    x ^= x >> 16;
+    x *= 0x85ebca6bu;
+    x ^= x >> 13;
+    x *= 0xc2b2ae35u;
+    x ^= x >> 16;
+    return x;
+}
+
+static bool is_sampled_set(set_sampling_t mode, uint32_t ratio, uint32_t set_idx) {
+    switch (mode) {
+        case SET_SAMPLING_STRIDED: return set_idx % ratio == 0;
+        case SET_SAMPLING_HASHED:  return set_sample_hash(set_idx) % ratio == 0;
+        default:                   return true;
+    }
+}
+
+// --- Slice Hashing ---
+
+// Bits XORed into the slice index, from the line-address bits above it
+static inline uint64_t slice_hash_bits(const cache_layer_t* cache, uint64_t upper) {
+    switch (cache->slice_hash) {
+        case SLICE_HASH_XOR: {
+            uint64_t folded = 0;
+            for (; upper; upper >>= cache->slice_shift) folded ^= upper;
+            return folded;
+        }
+        case SLICE_HASH_MIX: return (upper * 0x9E3779B97F4A7C15ull) >> 40;
+        default: return 0;
+    }
+}
+
+// Set index (before set sampling) and tag of a line; slices own contiguous runs of sets
+static inline uint64_t cache_index(const cache_layer_t* cache, uint64_t block_addr, uint32_t* set_idx) {
+    if (cache->num_slices == 1) {
+        *set_idx = block_addr % cache->num_sets;
+        return block_addr / cache->num_sets;
+    }
+    uint32_t slice_sets = cache->num_sets >> cache->slice_shift;
+    uint64_t upper = block_addr >> cache->slice_shift;
+    uint32_t slice = (block_addr ^ slice_hash_bits(cache, upper)) & (cache->num_slices - 1);
+    *set_idx = slice * slice_sets + upper % slice_sets;
+    return upper / slice_sets;
+}
+
+uint32_t cache_slice_of(const cache_layer_t* cache, uint64_t address) {
+    uint32_t set_idx;
+    cache_index(cache, address / cache->block_size, &set_idx);
+    return set_idx / (cache->num_sets >> cache->slice_shift);
+}
+
+// --- Line-ID Fast Path ---
+
+int cache_layer_bind_lines(cache_layer_t* cache, const uint64_t* lines, uint32_t num_lines, uint32_t line_size) {
+    if (!cache) return -1;
+    free(cache->line_slots);
+    cache->line_addrs = NULL;
+    cache->line_slots = NULL;
+    cache->num_line_slots = 0;
+    if (num_lines == 0) return 0;
+    if (line_size != cache->block_size || cache->num_sets > UINT32_MAX >> CACHE_SLOT_SLICE_BITS) return -1;
+
+    cache->line_slots = (cache_line_slot_t*)malloc((size_t)num_lines * sizeof(cache_line_slot_t));
+    if (!cache->line_slots) {
+        printf("Error: Failed to allocate line slots for %s\n", cache->name);
+        return -1;
+    }
+    uint32_t slice_sets = cache->num_sets >> cache->slice_shift;
+    for (uint32_t id = 1; id <= num_lines; id++) {
+        uint32_t set_idx;
+        uint64_t tag = cache_index(cache, lines[id], &set_idx);
+        if (tag > UINT32_MAX) {
+            free(cache->line_slots);
+            cache->line_slots = NULL;
+            return -1;
+        }
+        cache->line_slots[id - 1].tag = (uint32_t)tag;
+        cache->line_slots[id - 1].set_slice = set_idx << CACHE_SLOT_SLICE_BITS | set_idx / slice_sets;
+    }
+    cache->line_addrs = lines;
+    cache->num_line_slots = num_lines;
+    return 0;
+}
+
+// The access's precomputed placement, NULL if it has no line ID bound in this layer (ID 0 wraps)
+static inline const cache_line_slot_t* cache_line_slot(const cache_layer_t* cache, const memory_access_t* access) {
+    uint32_t index = access->line_id - 1;
+    return index < cache->num_line_slots ? &cache->line_slots[index] : NULL;
+}
+
+static inline uint64_t cache_line_address(const cache_layer_t* cache, const cache_line_slot_t* slot,
+                                          const memory_access_t* access) {
+    return slot ? cache->line_addrs[access->line_id] : access->address / cache->block_size;
+}
+
+static inline uint32_t cache_slot_slice(const cache_line_slot_t* slot) {
+    return slot->set_slice & ((1u << CACHE_SLOT_SLICE_BITS) - 1);
+}
+
+// cache_index through the slot when there is one
+static inline uint64_t cache_index_line(const cache_layer_t* cache, const cache_line_slot_t* slot,
+                                        uint64_t block_addr, uint32_t* set_idx) {
+    if (slot) {
+        *set_idx = slot->set_slice >> CACHE_SLOT_SLICE_BITS;
+        return slot->tag;
+    }
+    return cache_index(cache, block_addr, set_idx);
+}
+
+const char* slice_hash_name(slice_hash_t hash) {
+    switch (hash) {
+        case SLICE_HASH_XOR: return "xor";
+        case SLICE_HASH_MIX: return "mix";
+        default: return "linear";
+    }
+}
+
+int slice_hash_parse(const char* name, slice_hash_t* hash) {
+    if (strcmp(name, "linear") == 0) *hash = SLICE_HASH_LINEAR;
+    else if (strcmp(name, "xor") == 0) *hash = SLICE_HASH_XOR;
+    else if (strcmp(name, "mix") == 0) *hash = SLICE_HASH_MIX;
+    else {
+        printf("Error: Unknown slice hash '%s' (expected linear, xor or mix)\n", name);
+        return -1;
+    }
+    return 0;
+}
+
+// --- Specialized Kernels ---
+// With the way count a constant the compiler fully unrolls these loops; the comparisons are
+// folded into bit masks so lookup and victim choice carry no data-dependent branches.
+
+// Returns the way holding tag, or associativity if the set does not contain it
+static uint32_t cache_find_way_generic(const cache_set_t* set, uint64_t tag) {
+    for (uint32_t i = 0; i < set->associativity; i++) {
+        const cache_block_t* block = &set->blocks[i];
+        if (block->valid && block->tag == tag) return i;
+    }
+    return set->associativity;
+}
+
+// Wide sets: one hash probe, verified against the block since invalidations leave stale entries
+static uint32_t cache_find_way_directory(const cache_set_t* set, uint64_t tag) {
+    uint32_t way = hash_table_lookup(set->directory, tag);
+    if (way < set->associativity && set->blocks[way].valid && set->blocks[way].tag == tag) return way;
+    return set->associativity;
+}
+
+#define DEFINE_CACHE_KERNELS(WAYS) \
+static uint32_t cache_find_way_##WAYS(const cache_set_t* set, uint64_t tag) { \
+    const cache_block_t* blocks = set->blocks; \
+    uint32_t match = 0; \
+    for (uint32_t i = 0; i < WAYS; i++) match |= (uint32_t)(blocks[i].valid & (blocks[i].tag == tag)) << i; \
+    return match ? (uint32_t)__builtin_ctz(match) : WAYS; \
+} \
+/* First invalid way, else the first way with the oldest access time */ \
+static uint32_t cache_lru_victim_##WAYS(const cache_set_t* set) { \
+    const cache_block_t* blocks = set->blocks; \
+    uint32_t invalid = 0; \
+    for (uint32_t i = 0; i < WAYS; i++) invalid |= (uint32_t)!blocks[i].valid << i; \
+    if (invalid) return (uint32_t)__builtin_ctz(invalid); \
+    uint32_t victim = 0, oldest = blocks[0].access_time; \
+    for (uint32_t i = 1; i < WAYS; i++) { \
+        bool older = blocks[i].access_time < oldest; \
+        victim = older ? i : victim; \
+        oldest = older ? blocks[i].access_time : oldest; \
+    } \
+    return victim; \
+}
+CACHE_SPECIALIZED_WAYS(DEFINE_CACHE_KERNELS)
+#undef DEFINE_CACHE_KERNELS
+
+static void cache_select_kernels(cache_layer_t* cache) {
+    cache->find_way = cache_find_way_generic;
+    cache->lru_victim = NULL;
+    switch (cache->associativity) {
+#define CASE_CACHE_KERNELS(WAYS) \
+        case WAYS: \
+            cache->find_way = cache_find_way_##WAYS; \
+            if (cache->policy == REPLACEMENT_LRU) cache->lru_victim = cache_lru_victim_##WAYS; \
+            break;
+        CACHE_SPECIALIZED_WAYS(CASE_CACHE_KERNELS)
+#undef CASE_CACHE_KERNELS
+        default:
+            if (cache->associativity >= CACHE_DIRECTORY_MIN_WAYS) cache->find_way = cache_find_way_directory;
+            break;
+    }
+}
+
+cache_layer_t* cache_layer_create_sampled(
+    const char* name,
+    uint32_t size,
+    uint32_t block_size,
+    uint32_t associativity,
+    replacement_policy_t policy,
+    uint32_t latency,
+    set_sampling_t set_sampling,
+    uint32_t sample_ratio
 ) {
     cache_layer_t* cache = (cache_layer_t*)malloc(sizeof(cache_layer_t));
     if (!cache) return NULL;
@@ -25,18 +236,89 @@ cache_layer_t* cache_layer_create(
     cache->num_sets = size / (block_size * associativity);
     if (cache->num_sets == 0) cache->num_sets = 1; // Handle fully-associative case (1 set)
     
+    if (is_rrip_policy(policy) && associativity > RRIP_MAX_WAYS) {
+        printf("Error: %s supports at most %u ways (%s has %u)\n",
+            replacement_policy_name(policy), RRIP_MAX_WAYS, name, associativity);
+        free(cache);
+        return NULL;
+    }
+    
     cache->hits = 0;
     cache->misses = 0;
     cache->evictions = 0;
+    cache->sector_misses = 0;
+    cache->bytes_fetched = 0;
+    cache->bytes_written_back = 0;
+    cache->sector_size = block_size;
+    cache->sectors_per_line = 1;
     cache->next_level = NULL;
     
-    cache->sets = (cache_set_t*)calloc(cache->num_sets, sizeof(cache_set_t));
-    if (!cache->sets) {
+    cache->fast_path_hits = 0;
+    cache->miss_stream = NULL;
+    cache->prefetcher = NULL;
+    cache->clock = NULL;
+    cache->memory_latency = 0;
+    cache->memory = NULL;
+    cache->prefetch_requests = cache->prefetch_fills = cache->prefetch_memory_fills = 0;
+    cache->prefetch_useful = cache->prefetch_late = cache->prefetch_useless = 0;
+    for (uint32_t i = 0; i < CACHE_MEMO_SLOTS; i++) cache->memo_way[i] = UINT32_MAX;
+    cache->inclusion = INCLUSION_NINE;
+    cache->upper_level = NULL;
+    cache->handoff_valid = cache->handoff_dirty = 0;
+    cache->back_invalidations = cache->back_invalidated_dirty = cache->victim_fills = 0;
+    cache->write_hit = WRITE_BACK;
+    cache->write_miss = WRITE_ALLOCATE;
+    cache->writes = cache->write_hits = cache->write_no_allocates = 0;
+    cache->write_through_bytes = cache->writebacks_received = 0;
+    cache->num_shadows = 0;
+    cache_select_kernels(cache);
+    cache->partition = NULL;
+    cache->victim = NULL;
+    cache->num_slices = 1;
+    cache->slice_shift = 0;
+    cache->slice_hash = SLICE_HASH_LINEAR;
+    cache->slice_accesses = cache->slice_misses = NULL;
+    cache->line_addrs = NULL;
+    cache->line_slots = NULL;
+    cache->num_line_slots = 0;
+    cache->psel = DRRIP_PSEL_MAX / 2;
+    cache->brrip_fills = 0;
+    cache->ship_shct = NULL;
+    
+    // Set sampling: only the chosen sets get storage, the rest map to UINT32_MAX
+    cache->set_sampling = (sample_ratio > 1) ? set_sampling : SET_SAMPLING_NONE;
+    cache->sample_ratio = (cache->set_sampling == SET_SAMPLING_NONE) ? 1 : sample_ratio;
+    cache->sampled_sets = cache->num_sets;
+    cache->sampled_out = 0;
+    cache->set_map = NULL;
+    
+    if (cache->set_sampling != SET_SAMPLING_NONE) {
+        cache->set_map = (uint32_t*)malloc(cache->num_sets * sizeof(uint32_t));
+        if (!cache->set_map) {
+            free(cache);
+            return NULL;
+        }
+        
+        cache->sampled_sets = 0;
+        for (uint32_t i = 0; i < cache->num_sets; i++) {
+            bool sampled = is_sampled_set(cache->set_sampling, cache->sample_ratio, i);
+            cache->set_map[i] = sampled ? cache->sampled_sets++ : UINT32_MAX;
+        }
+        if (cache->sampled_sets == 0) cache->set_map[0] = cache->sampled_sets++; // Keep at least one set
+    }
+    
+    cache->sets = (cache_set_t*)calloc(cache->sampled_sets, sizeof(cache_set_t));
+    cache->touched_sets = (uint32_t*)malloc(cache->sampled_sets * sizeof(uint32_t));
+    cache->num_touched = 0;
+    if (!cache->sets || !cache->touched_sets) {
+        free(cache->sets);
+        free(cache->touched_sets);
+        free(cache->set_map);
         free(cache);
         return NULL;
     }
     
-    for (uint32_t i = 0; i < cache->num_sets; i++) {
+    for (uint32_t i = 0; i < cache->sampled_sets; i++) {
         cache->sets[i].blocks = (cache_block_t*)calloc(associativity, sizeof(cache_block_t));
         cache->sets[i].associativity = associativity;
         cache->sets[i].lru_counter = 0;
@@ -50,34 +332,437 @@ cache_layer_t* cache_layer_create(
         } else if (policy == REPLACEMENT_LFU) {
             cache->sets[i].lfu_heap = pq_create(associativity);
         }
+        if (cache->find_way == cache_find_way_directory) {
+            cache->sets[i].directory = hash_table_create(associativity * 2 + 1);
+        }
     }
     
     // Hash table is not used in this iteration of set-associative logic, 
     // as direct-mapped array access is faster when set index is known.
     cache->tag_table = NULL; 
     
+    // SHiP counters start weakly reused, so unseen regions insert at long like SRRIP
+    if (policy == REPLACEMENT_SHIP) {
+        cache->ship_shct = (uint8_t*)malloc(1u << SHIP_SIGNATURE_BITS);
+        if (!cache->ship_shct) {
+            cache_layer_free(cache);
+            return NULL;
+        }
+        memset(cache->ship_shct, 1, 1u << SHIP_SIGNATURE_BITS);
+    }
+    
     cache->next_level = NULL;
     return cache;
 }
 
-// Find an invalid block, or the victim based on policy
-uint32_t find_victim_block(cache_layer_t* cache, uint32_t set_idx) {
+int cache_layer_set_sectored(cache_layer_t* cache, uint32_t sector_size) {
+    if (!cache) return -1;
+    if (sector_size == 0 || cache->block_size % sector_size != 0 || cache->block_size / sector_size > 32) {
+        printf("Error: Sector size %u does not divide the %u-byte lines of %s into at most 32 sectors\n",
+            sector_size, cache->block_size, cache->name);
+        return -1;
+    }
+    cache->sector_size = sector_size;
+    cache->sectors_per_line = cache->block_size / sector_size;
+    return 0;
+}
+
+void cache_layer_set_prefetcher(cache_layer_t* cache, prefetcher_t* pf) {
+    if (!cache) return;
+    prefetcher_free(cache->prefetcher);
+    cache->prefetcher = pf;
+}
+
+int cache_layer_set_victim_cache(cache_layer_t* cache, victim_cache_t* vc) {
+    if (!cache) return -1;
+    if (vc && cache->next_level && cache->next_level->inclusion == INCLUSION_EXCLUSIVE) {
+        printf("Error: %s cannot have a victim cache in front of an exclusive next level\n", cache->name);
+        victim_cache_free(vc);
+        return -1;
+    }
+    victim_cache_free(cache->victim);
+    cache->victim = vc;
+    return 0;
+}
+
+int cache_layer_set_sliced(cache_layer_t* cache, uint32_t slices, slice_hash_t hash) {
+    if (!cache) return -1;
+    if (slices == 0 || slices > CACHE_MAX_SLICES || (slices & (slices - 1)) || cache->num_sets % slices) {
+        printf("Error: %s cannot be split into %u slices (a power of two up to %u dividing %u sets)\n",
+            cache->name, slices, CACHE_MAX_SLICES, cache->num_sets);
+        return -1;
+    }
+
+    // Allocate first, so a failure leaves the layer as it was
+    uint64_t* accesses = NULL;
+    uint64_t* misses = NULL;
+    if (slices > 1) {
+        accesses = (uint64_t*)calloc(slices, sizeof(uint64_t));
+        misses = (uint64_t*)calloc(slices, sizeof(uint64_t));
+        if (!accesses || !misses) {
+            free(accesses);
+            free(misses);
+            return -1;
+        }
+    }
+
+    free(cache->slice_accesses);
+    free(cache->slice_misses);
+    cache->slice_accesses = accesses;
+    cache->slice_misses = misses;
+    cache->num_slices = slices;
+    cache->slice_shift = 0;
+    while ((1u << cache->slice_shift) < slices) cache->slice_shift++;
+    cache->slice_hash = hash;
+    return 0;
+}
+
+// Every statistic a fork accumulates on its own
+#define CACHE_FORK_COUNTERS(X) \
+    X(hits) X(misses) X(evictions) X(sector_misses) X(bytes_fetched) X(bytes_written_back) \
+    X(sampled_out) X(fast_path_hits) X(prefetch_requests) X(prefetch_fills) X(prefetch_memory_fills) \
+    X(prefetch_useful) X(prefetch_late) X(prefetch_useless) X(back_invalidations) \
+    X(back_invalidated_dirty) X(victim_fills) X(writes) X(write_hits) X(write_no_allocates) \
+    X(write_through_bytes) X(writebacks_received)
+
+// Records set as modified since the last reset (see cache_layer_reset)
+static inline void cache_mark_touched(cache_layer_t* cache, cache_set_t* set) {
+    if (set->touched) return;
+    set->touched = true;
+    cache->touched_sets[cache->num_touched++] = (uint32_t)(set - cache->sets);
+}
+
+static void cache_set_rebuild_directory(cache_set_t* set) {
+    if (!set->directory) return;
+    hash_table_free(set->directory);
+    set->directory = hash_table_create(set->associativity * 2 + 1);
+    for (uint32_t w = 0; w < set->associativity; w++) {
+        if (set->blocks[w].valid) hash_table_insert(set->directory, set->blocks[w].tag, w);
+    }
+}
+
+int cache_layer_can_fork(const cache_layer_t* cache) {
+    const char* reason = NULL;
+    if (cache->num_slices == 1) reason = "it is not sliced";
+    else if (cache->prefetcher || cache->partition || cache->num_shadows || cache->victim) {
+        reason = "a prefetcher, partitioning, shadow tags or a victim cache is attached";
+    } else if (cache->next_level || cache->memory || cache->miss_stream || cache->upper_level) {
+        reason = "it is linked to other levels";
+    } else if (cache->policy != REPLACEMENT_LRU && cache->policy != REPLACEMENT_FIFO &&
+               cache->policy != REPLACEMENT_LFU && cache->policy != REPLACEMENT_SRRIP) {
+        reason = "its replacement policy keeps state shared by all sets";
+    }
+    if (reason) {
+        printf("Error: %s cannot be simulated slice-parallel: %s\n", cache->name, reason);
+        return -1;
+    }
+    return 0;
+}
+
+cache_layer_t* cache_layer_fork(cache_layer_t* cache) {
+    cache_layer_t* fork = (cache_layer_t*)malloc(sizeof(cache_layer_t));
+    if (!fork) return NULL;
+    // Mark every set up front: concurrent forks must never append to the shared touched list
+    for (uint32_t i = 0; i < cache->sampled_sets; i++) cache_mark_touched(cache, &cache->sets[i]);
+    *fork = *cache;
+#define ZERO_COUNTER(name) fork->name = 0;
+    CACHE_FORK_COUNTERS(ZERO_COUNTER)
+#undef ZERO_COUNTER
+    for (uint32_t i = 0; i < CACHE_MEMO_SLOTS; i++) fork->memo_way[i] = UINT32_MAX;
+    return fork;
+}
+
+void cache_layer_join(cache_layer_t* cache, cache_layer_t* fork) {
+#define ADD_COUNTER(name) cache->name += fork->name;
+    CACHE_FORK_COUNTERS(ADD_COUNTER)
+#undef ADD_COUNTER
+    // Memos may now point at lines a sibling replaced
+    for (uint32_t i = 0; i < CACHE_MEMO_SLOTS; i++) cache->memo_way[i] = UINT32_MAX;
+    free(fork);
+}
+
+void cache_layer_reset(cache_layer_t* cache) {
+    if (!cache) return;
+    // Sets nobody filled are still as created, so a short run costs a short reset
+    for (uint32_t i = 0; i < cache->num_touched; i++) {
+        cache_set_t* set = &cache->sets[cache->touched_sets[i]];
+        // The data bytes are never read back, so only the metadata in front of them is cleared
+        for (uint32_t w = 0; w < set->associativity; w++) memset(&set->blocks[w], 0, offsetof(cache_block_t, data));
+        set->lru_counter = 0;
+        set->rrpv = 0;
+        set->reused = 0;
+        if (set->fifo_queue) {
+            while (!queue_is_empty(set->fifo_queue)) queue_dequeue(set->fifo_queue);
+        }
+        if (set->lru_deque) {
+            while (!deque_is_empty(set->lru_deque)) deque_pop_front(set->lru_deque);
+        }
+        if (set->lfu_heap) set->lfu_heap->size = 0;
+        cache_set_rebuild_directory(set);
+        set->touched = false;
+    }
+    cache->num_touched = 0;
+
+#define ZERO_COUNTER(name) cache->name = 0;
+    CACHE_FORK_COUNTERS(ZERO_COUNTER)
+#undef ZERO_COUNTER
+    for (uint32_t i = 0; i < CACHE_MEMO_SLOTS; i++) cache->memo_way[i] = UINT32_MAX;
+    if (cache->num_slices > 1) {
+        memset(cache->slice_accesses, 0, cache->num_slices * sizeof(uint64_t));
+        memset(cache->slice_misses, 0, cache->num_slices * sizeof(uint64_t));
+    }
+    cache->handoff_valid = cache->handoff_dirty = 0;
+    cache->psel = DRRIP_PSEL_MAX / 2;
+    cache->brrip_fills = 0;
+    if (cache->ship_shct) memset(cache->ship_shct, 1, 1u << SHIP_SIGNATURE_BITS);
+
+    prefetcher_reset(cache->prefetcher);
+    partition_reset(cache->partition);
+    victim_cache_reset(cache->victim);
+    for (uint32_t i = 0; i < cache->num_shadows; i++) cache_layer_reset(cache->shadows[i]);
+}
+
+void cache_layer_rebuild_directories(cache_layer_t* cache) {
+    for (uint32_t i = 0; i < cache->sampled_sets; i++) {
+        cache_mark_touched(cache, &cache->sets[i]);
+        cache_set_rebuild_directory(&cache->sets[i]);
+    }
+}
+
+void cache_layer_set_partition(cache_layer_t* cache, partition_t* part) {
+    if (!cache) return;
+    partition_free(cache->partition);
+    cache->partition = part;
+}
+
+// One shadow: a hash-sampled, tag-only layer with the same sets, sectors and write policy
+static cache_layer_t* cache_shadow_create(const cache_layer_t* cache, replacement_policy_t policy,
+                                          uint32_t associativity) {
+    char name[32];
+    snprintf(name, sizeof(name), "%s %u-way", replacement_policy_name(policy), associativity);
+    cache_layer_t* shadow = cache_layer_create_sampled(name, cache->num_sets * cache->block_size * associativity,
+        cache->block_size, associativity, policy, cache->latency, SET_SAMPLING_HASHED, SHADOW_SAMPLE_RATIO);
+    if (!shadow) return NULL;
+    if (cache->sectors_per_line > 1 && cache_layer_set_sectored(shadow, cache->sector_size) != 0) {
+        cache_layer_free(shadow);
+        return NULL;
+    }
+    shadow->write_hit = cache->write_hit;
+    shadow->write_miss = cache->write_miss;
+    return shadow;
+}
+
+int cache_layer_add_shadow(cache_layer_t* cache, replacement_policy_t policy, uint32_t associativity) {
+    if (!cache) return -1;
+    if (cache->num_shadows + (cache->num_shadows == 0) >= CACHE_MAX_SHADOWS) {
+        printf("Error: %s takes at most %u shadow configurations\n", cache->name, CACHE_MAX_SHADOWS - 1);
+        return -1;
+    }
+    if (associativity == 0) {
+        printf("Error: Shadow tags need at least one way\n");
+        return -1;
+    }
+    if (cache->num_shadows == 0) {
+        cache->shadows[0] = cache_shadow_create(cache, cache->policy, cache->associativity);
+        if (!cache->shadows[0]) return -1;
+        cache->num_shadows = 1;
+    }
+    cache_layer_t* shadow = cache_shadow_create(cache, policy, associativity);
+    if (!shadow) return -1;
+    cache->shadows[cache->num_shadows++] = shadow;
+    return 0;
+}
+
+int shadow_spec_parse(const char* spec, replacement_policy_t* policy, uint32_t* associativity) {
+    char name[16] = "";
+    const char* colon = strchr(spec, ':');
+    size_t len = colon ? (size_t)(colon - spec) : strlen(spec);
+    if (len < sizeof(name)) memcpy(name, spec, len);
+    if (replacement_policy_parse(name, policy) != 0) return -1;
+    if (colon) *associativity = (uint32_t)strtoul(colon + 1, NULL, 0);
+    return 0;
+}
+
+const char* replacement_policy_name(replacement_policy_t policy) {
+    switch (policy) {
+        case REPLACEMENT_FIFO:   return "FIFO";
+        case REPLACEMENT_LFU:    return "LFU";
+        case REPLACEMENT_RANDOM: return "RANDOM";
+        case REPLACEMENT_SRRIP:  return "SRRIP";
+        case REPLACEMENT_BRRIP:  return "BRRIP";
+        case REPLACEMENT_DRRIP:  return "DRRIP";
+        case REPLACEMENT_SHIP:   return "SHiP";
+        default:                 return "LRU";
+    }
+}
+
+int replacement_policy_parse(const char* name, replacement_policy_t* policy) {
+    char upper[16] = "";
+    for (size_t i = 0; name[i] && i < sizeof(upper) - 1; i++) upper[i] = (char)toupper((unsigned char)name[i]);
+
+    for (int p = REPLACEMENT_LRU; p <= REPLACEMENT_SHIP; p++) {
+        const char* candidate = p == REPLACEMENT_SHIP ? "SHIP" : replacement_policy_name((replacement_policy_t)p);
+        if (strcmp(upper, candidate) == 0) {
+            *policy = (replacement_policy_t)p;
+            return 0;
+        }
+    }
+    printf("Error: Unknown replacement policy '%s' (expected lru, fifo, lfu, random, srrip, brrip, drrip or ship)\n", name);
+    return -1;
+}
+
+const char* inclusion_policy_name(inclusion_policy_t inclusion) {
+    switch (inclusion) {
+        case INCLUSION_INCLUSIVE: return "inclusive";
+        case INCLUSION_EXCLUSIVE: return "exclusive";
+        default:                  return "nine";
+    }
+}
+
+int inclusion_policy_parse(const char* name, inclusion_policy_t* inclusion) {
+    for (int i = INCLUSION_NINE; i <= INCLUSION_EXCLUSIVE; i++) {
+        if (strcmp(name, inclusion_policy_name((inclusion_policy_t)i)) == 0) {
+            *inclusion = (inclusion_policy_t)i;
+            return 0;
+        }
+    }
+    printf("Error: Unknown inclusion policy '%s' (expected nine, inclusive or exclusive)\n", name);
+    return -1;
+}
+
+const char* write_hit_policy_name(write_hit_policy_t policy) {
+    return policy == WRITE_THROUGH ? "through" : "back";
+}
+
+const char* write_miss_policy_name(write_miss_policy_t policy) {
+    return policy == WRITE_NO_ALLOCATE ? "no-allocate" : "allocate";
+}
+
+int write_policy_parse(const char* spec, write_hit_policy_t* hit, write_miss_policy_t* miss) {
+    char hit_name[16] = "";
+    const char* colon = strchr(spec, ':');
+    size_t len = colon ? (size_t)(colon - spec) : strlen(spec);
+    if (len < sizeof(hit_name)) memcpy(hit_name, spec, len);
+
+    int h, m = colon ? -1 : (int)*miss;
+    for (h = WRITE_BACK; h <= WRITE_THROUGH; h++) {
+        if (strcmp(hit_name, write_hit_policy_name((write_hit_policy_t)h)) == 0) break;
+    }
+    for (int i = WRITE_ALLOCATE; colon && i <= WRITE_NO_ALLOCATE; i++) {
+        if (strcmp(colon + 1, write_miss_policy_name((write_miss_policy_t)i)) == 0) m = i;
+    }
+    if (h > WRITE_THROUGH || m < 0) {
+        printf("Error: Unknown write policy '%s' (expected back|through[:allocate|:no-allocate])\n", spec);
+        return -1;
+    }
+    *hit = (write_hit_policy_t)h;
+    *miss = (write_miss_policy_t)m;
+    return 0;
+}
+
+// --- RRIP Family ---
+
+static inline uint32_t rrip_get(const cache_set_t* set, uint32_t way) {
+    return (uint32_t)(set->rrpv >> (2 * way)) & 3u;
+}
+
+static inline void rrip_set(cache_set_t* set, uint32_t way, uint32_t value) {
+    set->rrpv = (set->rrpv & ~(3ull << (2 * way))) | ((uint64_t)value << (2 * way));
+}
+
+// First way of mask predicted to be re-referenced in the distant future; when none is, the ways
+// of mask are aged by the same amount that brings the oldest to distant
+static uint32_t rrip_victim(cache_set_t* set, uint64_t mask) {
+    uint32_t victim = UINT32_MAX, max = 0;
+    for (uint32_t i = 0; i < set->associativity; i++) {
+        if (!(mask >> i & 1)) continue;
+        uint32_t v = rrip_get(set, i);
+        if (victim == UINT32_MAX || v > max) {
+            max = v;
+            victim = i;
+            if (v == RRIP_DISTANT) return victim;
+        }
+    }
+    for (uint32_t i = 0; i < set->associativity; i++) {
+        if (mask >> i & 1) rrip_set(set, i, rrip_get(set, i) + RRIP_DISTANT - max);
+    }
+    return victim;
+}
+
+// DRRIP leader role of a set: 1 = SRRIP leader, 2 = BRRIP leader, 0 = follower
+static inline uint32_t drrip_leader(const cache_layer_t* cache, uint32_t set_idx) {
+    uint32_t stride = cache->sampled_sets / DRRIP_LEADER_SETS;
+    if (stride < 2) stride = 2;
+    if (set_idx % stride == 0) return 1;
+    if (set_idx % stride == stride / 2) return 2;
+    return 0;
+}
+
+static inline uint16_t ship_signature(uint64_t address) {
+    return (uint16_t)((uint32_t)((address >> SHIP_REGION_SHIFT) * 2654435761u) >> (32 - SHIP_SIGNATURE_BITS));
+}
+
+static inline uint32_t brrip_insert(cache_layer_t* cache) {
+    return (cache->brrip_fills++ % BRRIP_LONG_INTERVAL == 0) ? RRIP_LONG : RRIP_DISTANT;
+}
+
+// Insertion prediction for a fill into set_idx; also trains DRRIP on the miss
+static uint32_t rrip_insert(cache_layer_t* cache, uint32_t set_idx, uint16_t signature) {
+    switch (cache->policy) {
+        case REPLACEMENT_BRRIP:
+            return brrip_insert(cache);
+        case REPLACEMENT_DRRIP: {
+            uint32_t leader = drrip_leader(cache, set_idx);
+            if (leader == 1 && cache->psel < DRRIP_PSEL_MAX) cache->psel++;
+            if (leader == 2 && cache->psel > 0) cache->psel--;
+            bool bimodal = leader == 2 || (leader == 0 && cache->psel > DRRIP_PSEL_MAX / 2);
+            return bimodal ? brrip_insert(cache) : RRIP_LONG;
+        }
+        case REPLACEMENT_SHIP:
+            return cache->ship_shct[signature] == 0 ? RRIP_DISTANT : RRIP_LONG;
+        default:
+            return RRIP_LONG;
+    }
+}
+
+// FIFO restricted to mask: the oldest queued way of mask leaves, the others keep their order
+static uint32_t fifo_victim(cache_set_t* set, uint64_t mask) {
+    uint32_t victim = UINT32_MAX;
+    uint32_t n = set->fifo_queue->size;
+    for (uint32_t i = 0; i < n; i++) {
+        uint32_t way = (uint32_t)queue_dequeue(set->fifo_queue);
+        if (victim == UINT32_MAX && (mask >> way & 1)) victim = way;
+        else queue_enqueue(set->fifo_queue, way);
+    }
+    return victim;
+}
+
+// Find an invalid block, or the victim based on policy. Under way partitioning only the ways of
+// the filling access's partition are candidates.
+uint32_t find_victim_block(cache_layer_t* cache, uint32_t set_idx, const memory_access_t* access) {
     cache_set_t* set = &cache->sets[set_idx];
+    if (cache->lru_victim && !cache->partition) return cache->lru_victim(set);
+    cache_mark_touched(cache, set); // RRIP ages the set even if the caller ends up not filling
+    uint64_t mask = UINT64_MAX;
+    if (cache->partition) mask = cache->partition->masks[partition_of(cache->partition, access)];
     
     // First, check for an empty (invalid) block
     for (uint32_t i = 0; i < set->associativity; i++) {
-        if (!set->blocks[i].valid) return i;
+        if (!set->blocks[i].valid && (mask >> i & 1)) return i;
     }
     
     // No empty block, must evict based on policy
     switch (cache->policy) {
-        case REPLACEMENT_LRU: {
-            uint32_t victim = 0;
-            uint32_t min_time = set->blocks[0].access_time;
-            
-            for (uint32_t i = 1; i < set->associativity; i++) {
-                if (set->blocks[i].access_time < min_time) {
-                    min_time = set->blocks[i].access_time;
+        case REPLACEMENT_LRU:
+        case REPLACEMENT_LFU: {
+            // LRU evicts the oldest access time, LFU the lowest access count
+            bool lru = cache->policy == REPLACEMENT_LRU;
+            uint32_t victim = UINT32_MAX, min = 0;
+            for (uint32_t i = 0; i < set->associativity; i++) {
+                if (!(mask >> i & 1)) continue;
+                uint32_t key = lru ? set->blocks[i].access_time : set->blocks[i].access_count;
+                if (victim == UINT32_MAX || key < min) {
+                    min = key;
                     victim = i;
                 }
             }
@@ -85,77 +770,614 @@ uint32_t find_victim_block(cache_layer_t* cache, uint32_t set_idx) {
         }
         
         case REPLACEMENT_FIFO: {
-            // FIFO in this implementation relies on finding the victim with the oldest insertion time. 
-            // Since we don't track insertion time, we use the first valid block (simplification for array model)
-            // Or use the queue for a more accurate model (index is stored in the queue)
-            if (set->fifo_queue) return queue_dequeue(set->fifo_queue);
+            // The queue holds ways in fill order (index is stored in the queue)
+            if (!set->fifo_queue) return 0;
+            if (mask == UINT64_MAX) return queue_dequeue(set->fifo_queue);
+            uint32_t victim = fifo_victim(set, mask);
+            if (victim != UINT32_MAX) return victim;
+            for (uint32_t i = 0; i < set->associativity; i++) {
+                if (mask >> i & 1) return i;
+            }
             return 0;
         }
         
         case REPLACEMENT_RANDOM: {
-            return rand() % set->associativity;
-        }
-        
-        case REPLACEMENT_LFU: {
-            // This implementation uses the block with the lowest access count
-            uint32_t victim = 0;
-            uint32_t min_count = set->blocks[0].access_count;
-            
-            for (uint32_t i = 1; i < set->associativity; i++) {
-                if (set->blocks[i].access_count < min_count) {
-                    min_count = set->blocks[i].access_count;
-                    victim = i;
-                }
+            if (mask == UINT64_MAX) return rand() % set->associativity;
+            uint32_t candidates[PARTITION_MAX_WAYS], n = 0;
+            for (uint32_t i = 0; i < set->associativity; i++) {
+                if (mask >> i & 1) candidates[n++] = i;
             }
-            return victim;
+            return candidates[rand() % n];
         }
         
+        case REPLACEMENT_SRRIP:
+        case REPLACEMENT_BRRIP:
+        case REPLACEMENT_DRRIP:
+        case REPLACEMENT_SHIP:
+            return rrip_victim(set, mask);
+        
         default:
             return 0;
     }
 }
 
+// Bit of the sector holding address within its line
+static inline uint32_t cache_sector_bit(const cache_layer_t* cache, uint64_t address) {
+    if (cache->sectors_per_line == 1) return 1u;
+    return 1u << ((address % cache->block_size) / cache->sector_size);
+}
+
+static inline uint32_t cache_full_line_mask(const cache_layer_t* cache) {
+    return cache->sectors_per_line == 32 ? UINT32_MAX : (1u << cache->sectors_per_line) - 1;
+}
+
+static inline uint32_t count_bits(uint32_t mask) {
+    uint32_t n = 0;
+    for (; mask; mask &= mask - 1) n++;
+    return n;
+}
+
+// Replacement metadata update for a hit on an existing block
+static inline void cache_touch_block(cache_layer_t* cache, cache_set_t* set, uint32_t way,
+                                     const memory_access_t* access, uint32_t sector_bit) {
+    cache_block_t* block = &set->blocks[way];
+
+    // Update access time/count for LRU/LFU
+    block->access_time = set->lru_counter++;
+    block->access_count++;
+
+    // RRIP hit promotion: predict near-immediate re-reference
+    if (is_rrip_policy(cache->policy)) {
+        rrip_set(set, way, 0);
+        if (cache->ship_shct && !(set->reused & (1u << way))) {
+            set->reused |= 1u << way;
+            if (cache->ship_shct[block->signature] < SHIP_COUNTER_MAX) cache->ship_shct[block->signature]++;
+        }
+    }
+
+    // Write-through lines stay clean: the data has already gone below
+    if (access->type == ACCESS_WRITE && cache->write_hit == WRITE_BACK) {
+        block->dirty = true;
+        block->sector_dirty |= sector_bit;
+    }
+}
+
+// Installs tag into the chosen way with the sectors in sector_mask and resets its replacement metadata
+static inline void cache_fill_block(cache_layer_t* cache, cache_set_t* set, uint32_t way, uint64_t tag,
+                                    const memory_access_t* access, uint32_t sector_mask) {
+    cache_block_t* victim = &set->blocks[way];
+    cache_mark_touched(cache, set);
+    
+    if (is_rrip_policy(cache->policy)) {
+        // SHiP learns from lines evicted without reuse, whichever path replaces them
+        if (cache->ship_shct) {
+            if (victim->valid && !(set->reused & (1u << way)) && cache->ship_shct[victim->signature] > 0) {
+                cache->ship_shct[victim->signature]--;
+            }
+            victim->signature = ship_signature(access->address);
+            set->reused &= ~(1u << way);
+        }
+        rrip_set(set, way, rrip_insert(cache, (uint32_t)(set - cache->sets), victim->signature));
+    }
+    
+    if (set->directory) {
+        if (hash_table_lookup(set->directory, victim->tag) == way) hash_table_delete(set->directory, victim->tag);
+        hash_table_insert(set->directory, tag, way);
+    }
+    victim->valid = true;
+    victim->tag = tag;
+    victim->owner = cache->partition ? (uint8_t)partition_of(cache->partition, access) : 0;
+    victim->dirty = (access->type == ACCESS_WRITE && cache->write_hit == WRITE_BACK);
+    victim->sector_valid = sector_mask;
+    victim->sector_dirty = victim->dirty ? sector_mask : 0;
+    victim->prefetched = false;
+    
+    // Reset metadata for the new block
+    victim->access_time = set->lru_counter++;
+    victim->access_count = 1;
+    
+    // Update FIFO/LRU tracking structures if used for selection
+    if (cache->policy == REPLACEMENT_FIFO) {
+        // Enqueue the new block index
+        queue_enqueue(set->fifo_queue, way);
+    } 
+}
+
+// Demand hit bookkeeping; returns true on the first demand use of a prefetched block
+static inline bool cache_demand_hit(cache_layer_t* cache, cache_set_t* set, uint32_t way,
+                                    const memory_access_t* access, uint32_t sector_bit) {
+    cache->hits++;
+    if (access->type == ACCESS_WRITE) cache->write_hits++;
+    if (cache->partition) partition_observe(cache->partition, access, access->address / cache->block_size, true);
+    cache_touch_block(cache, set, way, access, sector_bit);
+
+    cache_block_t* block = &set->blocks[way];
+    if (!block->prefetched) return false;
+    block->prefetched = false;
+    if (cache->clock && *cache->clock < block->prefetch_ready) cache->prefetch_late++;
+    else cache->prefetch_useful++;
+    return true;
+}
+
+static inline uint64_t cache_block_address(const cache_layer_t* cache, const cache_block_t* block,
+                                           uint32_t logical_set) {
+    if (cache->num_slices == 1) return (block->tag * cache->num_sets + logical_set) * cache->block_size;
+    uint32_t slice_sets = cache->num_sets >> cache->slice_shift;
+    uint64_t upper = block->tag * slice_sets + logical_set % slice_sets;
+    uint64_t low = (logical_set / slice_sets ^ slice_hash_bits(cache, upper)) & (cache->num_slices - 1);
+    return (upper << cache->slice_shift | low) * cache->block_size;
+}
+
+// Set and way holding the line of address, or NULL (also for sets outside the sample)
+static cache_block_t* cache_lookup(cache_layer_t* cache, uint64_t address, cache_set_t** set_out) {
+    uint32_t set_idx;
+    uint64_t tag = cache_index(cache, address / cache->block_size, &set_idx);
+    if (cache->set_map) {
+        set_idx = cache->set_map[set_idx];
+        if (set_idx == UINT32_MAX) return NULL;
+    }
+    cache_set_t* set = &cache->sets[set_idx];
+    uint32_t way = cache->find_way(set, tag);
+    if (way == cache->associativity) return NULL;
+    if (set_out) *set_out = set;
+    return &set->blocks[way];
+}
+
+// Drops a block outside replacement; FIFO forgets its slot so a refill is queued afresh
+static inline void cache_invalidate_block(cache_set_t* set, cache_block_t* block) {
+    block->valid = false;
+    block->prefetched = false;
+    if (set->fifo_queue) queue_remove(set->fifo_queue, (uint32_t)(block - set->blocks));
+}
+
+// Exclusive: merges the line the lower layer just handed up into block
+static inline void cache_take_handoff(cache_layer_t* cache, cache_block_t* block) {
+    cache_layer_t* next = cache->next_level;
+    if (!next || next->inclusion != INCLUSION_EXCLUSIVE) return;
+    block->sector_valid |= next->handoff_valid;
+    if (next->handoff_dirty) {
+        block->dirty = true;
+        block->sector_dirty |= next->handoff_dirty;
+    }
+}
+
+static inline void cache_evict_block(cache_layer_t* cache, cache_block_t* victim, uint32_t logical_set,
+                                     const memory_access_t* access);
+
+// Installs (or merges into) the line at address with the given valid and dirty sectors
+static void cache_install_line(cache_layer_t* cache, uint64_t address, uint32_t sector_valid,
+                               uint32_t sector_dirty, const memory_access_t* access, bool warm);
+
+// Inclusion side effects of replacing a valid block; warm = functional only, no statistics
+static void cache_inclusion_evict(cache_layer_t* cache, cache_block_t* victim, uint32_t logical_set,
+                                  const memory_access_t* access, bool warm) {
+    uint64_t address = cache_block_address(cache, victim, logical_set);
+
+    // Inclusive: copies above must go too; their dirty data leaves with this victim
+    if (cache->inclusion == INCLUSION_INCLUSIVE && cache->upper_level) {
+        cache_layer_t* upper = cache->upper_level;
+        for (uint64_t a = address; a < address + cache->block_size; a += upper->block_size) {
+            uint32_t buffered_dirty;
+            if (upper->victim && victim_cache_invalidate(upper->victim, a / upper->block_size, &buffered_dirty) &&
+                buffered_dirty) {
+                victim->dirty = true;
+                victim->sector_dirty |= buffered_dirty;
+            }
+            cache_set_t* copy_set;
+            cache_block_t* copy = cache_lookup(upper, a, &copy_set);
+            if (!copy) continue;
+            if (!warm) cache->back_invalidations++;
+            if (copy->dirty) {
+                if (!warm) cache->back_invalidated_dirty++;
+                victim->dirty = true;
+                victim->sector_dirty |= copy->sector_dirty;
+            }
+            cache_invalidate_block(copy_set, copy);
+        }
+    }
+
+    // Exclusive lower layer: every line evicted from here moves down
+    if (cache->next_level && cache->next_level->inclusion == INCLUSION_EXCLUSIVE) {
+        cache_install_line(cache->next_level, address, victim->sector_valid,
+            victim->dirty ? victim->sector_dirty : 0, access, warm);
+        if (!warm) cache->next_level->victim_fills++;
+    }
+}
+
+static void cache_install_line(cache_layer_t* cache, uint64_t address, uint32_t sector_valid,
+                               uint32_t sector_dirty, const memory_access_t* access, bool warm) {
+    uint64_t block_addr = address / cache->block_size;
+    uint32_t set_idx;
+    uint64_t tag = cache_index(cache, block_addr, &set_idx);
+    uint32_t logical_set = set_idx;
+    if (cache->set_map) {
+        set_idx = cache->set_map[set_idx];
+        if (set_idx == UINT32_MAX) return;
+    }
+
+    cache_set_t* set = &cache->sets[set_idx];
+    uint32_t way = cache->find_way(set, tag);
+    memory_access_t fill = *access;
+    fill.address = address;
+    fill.type = ACCESS_READ;
+    fill.line_id = 0; // Another line than the demand's
+
+    if (way == cache->associativity) {
+        way = find_victim_block(cache, set_idx, &fill);
+        cache_block_t* victim = &set->blocks[way];
+        if (warm) {
+            if (victim->valid) cache_inclusion_evict(cache, victim, logical_set, &fill, true);
+        } else {
+            cache_evict_block(cache, victim, logical_set, &fill);
+        }
+        cache_fill_block(cache, set, way, tag, &fill, sector_valid);
+    } else {
+        set->blocks[way].sector_valid |= sector_valid;
+    }
+
+    if (sector_dirty) {
+        set->blocks[way].dirty = true;
+        set->blocks[way].sector_dirty |= sector_dirty;
+    }
+}
+
+// Sends the dirty sectors of the line at address to the level below
+static void cache_write_dirty_line(cache_layer_t* cache, uint64_t address, uint32_t sector_dirty,
+                                   const memory_access_t* access) {
+    cache->bytes_written_back += count_bits(sector_dirty) * cache->sector_size;
+
+    if (cache->next_level) {
+        // Writeback the dirty block to the next level (an exclusive one already took it on eviction)
+        cache->evictions++;
+        if (cache->miss_stream) miss_stream_record(cache->miss_stream, address, MISS_RECORD_WRITEBACK, access);
+        if (cache->next_level->inclusion != INCLUSION_EXCLUSIVE) {
+            // Sector masks only carry over between levels with the same sectoring
+            uint32_t mask = cache->next_level->sector_size == cache->sector_size ? sector_dirty : UINT32_MAX;
+            cache_writeback(cache->next_level, address, mask, access);
+        }
+    } else if (cache->memory) {
+        // Last level: posted write to DRAM, occupying its bank and bus
+        dram_write(cache->memory, address, count_bits(sector_dirty) * cache->sector_size,
+            cache->clock ? *cache->clock : 0);
+    }
+}
+
+// Accounts for the valid block about to be replaced: writeback of dirty data, unused prefetches.
+// With a victim cache the block moves there and only what it displaces is written back.
+static inline void cache_evict_block(cache_layer_t* cache, cache_block_t* victim, uint32_t logical_set,
+                                     const memory_access_t* access) {
+    if (!victim->valid) return;
+    cache_inclusion_evict(cache, victim, logical_set, access, false);
+    if (victim->prefetched) cache->prefetch_useless++;
+
+    uint64_t address = cache_block_address(cache, victim, logical_set);
+    uint32_t sector_dirty = victim->dirty ? victim->sector_dirty : 0;
+    if (cache->victim) {
+        victim_entry_t displaced;
+        if (!victim_cache_insert(cache->victim, address / cache->block_size, victim->sector_valid, sector_dirty,
+                                 &displaced)) return;
+        address = displaced.line * cache->block_size;
+        sector_dirty = displaced.sector_dirty;
+    }
+    if (sector_dirty) cache_write_dirty_line(cache, address, sector_dirty, access);
+}
+
+static inline void cache_memo_update(cache_layer_t* cache, const memory_access_t* access,
+                                     uint64_t block_addr, uint64_t tag, uint32_t set_idx, uint32_t way) {
+    uint32_t m = access->block_id % CACHE_MEMO_SLOTS;
+    cache->memo_block_addr[m] = block_addr;
+    cache->memo_tag[m] = tag;
+    cache->memo_set[m] = set_idx;
+    cache->memo_way[m] = way;
+}
+
+// Fast path: same line as this SM's previous access and still resident in the same way.
+// Performs exactly the regular hit update, minus the set index/tag math and the set scan.
+static inline bool cache_memo_hit(cache_layer_t* cache, const memory_access_t* access, uint64_t block_addr,
+                                  uint32_t sector_bit, bool* prefetch_hit) {
+    uint32_t m = access->block_id % CACHE_MEMO_SLOTS;
+    if (cache->memo_way[m] == UINT32_MAX || cache->memo_block_addr[m] != block_addr) return false;
+
+    cache_set_t* set = &cache->sets[cache->memo_set[m]];
+    cache_block_t* block = &set->blocks[cache->memo_way[m]];
+    if (!block->valid || block->tag != cache->memo_tag[m] || !(block->sector_valid & sector_bit)) return false;
+
+    cache->fast_path_hits++;
+    *prefetch_hit = cache_demand_hit(cache, set, cache->memo_way[m], access, sector_bit);
+    return true;
+}
+
+// Latency of fetching bytes at address from the backing store below this (last) level
+static uint32_t cache_memory_fetch(cache_layer_t* cache, uint64_t address, uint32_t bytes) {
+    if (!cache->memory) return cache->memory_latency;
+    uint64_t now = cache->clock ? *cache->clock : 0;
+    return (uint32_t)(dram_read(cache->memory, address, bytes, now) - now);
+}
+
+// Fetches one prefetch candidate into the layer unless it is already resident
+static void cache_prefetch_fill(cache_layer_t* cache, uint64_t block_addr, const memory_access_t* origin) {
+    cache->prefetch_requests++;
+
+    uint32_t set_idx;
+    uint64_t tag = cache_index(cache, block_addr, &set_idx);
+    uint32_t logical_set = set_idx;
+    if (cache->set_map) {
+        set_idx = cache->set_map[set_idx];
+        if (set_idx == UINT32_MAX) return;
+    }
+
+    cache_set_t* set = &cache->sets[set_idx];
+    if (cache->find_way(set, tag) < cache->associativity) return;
+
+    memory_access_t fetch = {
+        .address = block_addr * cache->block_size,
+        .type = ACCESS_READ,
+        .thread_id = origin->thread_id,
+        .block_id = origin->block_id,
+        .stream_id = origin->stream_id
+    };
+
+    // Arrival time: the level that supplied the line plus everything above it
+    uint32_t latency;
+    bool next_hit = false;
+    if (cache->next_level) {
+        cache_layer_t* next = cache->next_level;
+        next_hit = cache_warm(next, &fetch);
+        latency = next->latency;
+        if (!next_hit) {
+            latency += next->next_level ? next->next_level->latency
+                                        : cache_memory_fetch(next, fetch.address, next->block_size);
+        }
+    } else {
+        latency = cache_memory_fetch(cache, fetch.address, cache->block_size);
+    }
+    if (!next_hit) cache->prefetch_memory_fills++;
+
+    uint32_t way = find_victim_block(cache, set_idx, &fetch);
+    cache_evict_block(cache, &set->blocks[way], logical_set, &fetch);
+    cache_fill_block(cache, set, way, tag, &fetch, cache_full_line_mask(cache));
+    cache->bytes_fetched += cache->block_size;
+
+    cache_block_t* block = &set->blocks[way];
+    if (next_hit) cache_take_handoff(cache, block);
+    block->prefetched = true;
+    block->prefetch_ready = (cache->clock ? *cache->clock : 0) + latency;
+    cache->prefetch_fills++;
+}
+
+static inline void cache_record_miss(cache_layer_t* cache, const memory_access_t* access) {
+    if (cache->miss_stream) {
+        miss_stream_record(cache->miss_stream, access->address,
+            access->type == ACCESS_WRITE ? MISS_RECORD_WRITE : MISS_RECORD_READ, access);
+    }
+}
+
+// forwarded = a store passed down by a write-through or no-allocate layer above rather than a
+// miss it fills from here: an exclusive layer applies it like any other write instead of moving
+// the line up
+static bool cache_level_access(cache_layer_t* cache, memory_access_t* access, bool forwarded);
+static bool cache_level_warm(cache_layer_t* cache, memory_access_t* access, bool forwarded);
+
+// Forwards a write's data below without waiting for it: write-through hits, no-allocate misses
+static void cache_write_through(cache_layer_t* cache, memory_access_t* access) {
+    cache->write_through_bytes += cache->sector_size;
+    if (cache->miss_stream) miss_stream_record(cache->miss_stream, access->address, MISS_RECORD_WRITE, access);
+    if (cache->next_level) {
+        cache_level_access(cache->next_level, access, true);
+    } else if (cache->memory) {
+        dram_write(cache->memory, access->address, cache->sector_size, cache->clock ? *cache->clock : 0);
+    }
+}
+
+// Feeds a demand access to the shadows if its set is in their sample
+static void cache_shadow_access(cache_layer_t* cache, memory_access_t* access, bool warm) {
+    uint32_t logical_set = (access->address / cache->block_size) % cache->num_sets;
+    if (cache->shadows[0]->set_map[logical_set] == UINT32_MAX) return;
+    for (uint32_t i = 0; i < cache->num_shadows; i++) {
+        if (warm) cache_warm(cache->shadows[i], access);
+        else cache_access(cache->shadows[i], access);
+    }
+}
+
+// Trains the prefetcher on a demand access and issues what it proposes
+static void cache_prefetch(cache_layer_t* cache, const memory_access_t* access, uint64_t block_addr,
+                           bool hit, bool prefetch_hit) {
+    uint64_t candidates[PREFETCH_MAX_DEGREE];
+    prefetch_event_t event = { access, block_addr, hit, prefetch_hit };
+
+    uint32_t n = cache->prefetcher->observe(cache->prefetcher, &event, candidates, PREFETCH_MAX_DEGREE);
+    for (uint32_t i = 0; i < n; i++) cache_prefetch_fill(cache, candidates[i], access);
+}
+
+// Victim cache probe on a full miss: a buffered line swaps places with the block it replaces.
+// Returns its way, or associativity if the line is not buffered.
+static uint32_t cache_victim_swap(cache_layer_t* cache, cache_set_t* set, uint32_t set_idx, uint32_t logical_set,
+                                  uint64_t tag, const memory_access_t* access) {
+    victim_entry_t entry;
+    if (!victim_cache_take(cache->victim, access->address / cache->block_size, &entry)) return cache->associativity;
+
+    uint32_t way = find_victim_block(cache, set_idx, access);
+    cache_block_t* block = &set->blocks[way];
+    cache_evict_block(cache, block, logical_set, access);
+
+    memory_access_t fill = *access;
+    fill.type = ACCESS_READ; // Dirty state comes from the buffer; the demand write is applied on touch
+    cache_fill_block(cache, set, way, tag, &fill, entry.sector_valid);
+    if (entry.sector_dirty) {
+        block->dirty = true;
+        block->sector_dirty |= entry.sector_dirty;
+    }
+    return way;
+}
+
+// Exclusive layer serving a miss of the layer above: a resident line moves up (its sectors are
+// reported through handoff_valid/handoff_dirty), a missing one is fetched from below without
+// being installed here. warm = functional only, no statistics.
+static bool cache_exclusive_access(cache_layer_t* cache, memory_access_t* access, bool warm) {
+    const cache_line_slot_t* slot = cache_line_slot(cache, access);
+    uint64_t block_addr = cache_line_address(cache, slot, access);
+    uint32_t set_idx;
+    uint64_t tag = cache_index_line(cache, slot, block_addr, &set_idx);
+    cache->handoff_valid = cache->handoff_dirty = 0;
+    if (cache->set_map) {
+        set_idx = cache->set_map[set_idx];
+        if (set_idx == UINT32_MAX) {
+            if (!warm) cache->sampled_out++;
+            return false;
+        }
+    }
+    if (!warm && access->type == ACCESS_WRITE) cache->writes++;
+
+    cache_set_t* set = &cache->sets[set_idx];
+    uint32_t sector_bit = cache_sector_bit(cache, access->address);
+    uint32_t way = cache->find_way(set, tag);
+    bool hit = way < cache->associativity && (set->blocks[way].sector_valid & sector_bit);
+    bool prefetch_hit = false;
+
+    if (warm) {
+        if (!hit && cache->next_level) cache_warm(cache->next_level, access);
+    } else if (hit) {
+        prefetch_hit = cache_demand_hit(cache, set, way, access, sector_bit);
+    } else {
+        cache->misses++;
+        if (cache->slice_misses) cache->slice_misses[slot ? cache_slot_slice(slot) : cache_slice_of(cache, access->address)]++;
+        if (cache->partition) partition_observe(cache->partition, access, block_addr, false);
+        cache->bytes_fetched += cache->sector_size;
+        if (way < cache->associativity) cache->sector_misses++;
+        cache_record_miss(cache, access);
+        if (cache->next_level) cache_access(cache->next_level, access);
+    }
+
+    if (way < cache->associativity) {
+        cache_block_t* block = &set->blocks[way];
+        cache->handoff_valid = block->sector_valid;
+        cache->handoff_dirty = block->dirty ? block->sector_dirty : 0;
+        cache_invalidate_block(set, block);
+    }
+
+    if (!warm && cache->prefetcher) cache_prefetch(cache, access, block_addr, hit, prefetch_hit);
+    return hit;
+}
+
 bool cache_access(cache_layer_t* cache, memory_access_t* access) {
+    return cache_level_access(cache, access, false);
+}
+
+static bool cache_level_access(cache_layer_t* cache, memory_access_t* access, bool forwarded) {
     if (!cache) return false;
+    if (cache->num_shadows) cache_shadow_access(cache, access, false);
+    const cache_line_slot_t* slot = cache_line_slot(cache, access);
+    uint32_t slice = 0;
+    if (cache->slice_accesses) {
+        slice = slot ? cache_slot_slice(slot) : cache_slice_of(cache, access->address);
+        cache->slice_accesses[slice]++;
+    }
+    if (cache->inclusion == INCLUSION_EXCLUSIVE && cache->upper_level && !forwarded) {
+        return cache_exclusive_access(cache, access, false);
+    }
+    bool write = access->type == ACCESS_WRITE;
+    bool write_through = write && cache->write_hit == WRITE_THROUGH;
     
-    uint64_t block_addr = access->address / cache->block_size;
-    uint32_t set_idx = block_addr % cache->num_sets;
-    uint64_t tag = block_addr / cache->num_sets;
+    // 0. Check the last-line memo
+    PROF_BEGIN(PROF_FAST_PATH);
+    uint64_t block_addr = cache_line_address(cache, slot, access);
+    uint32_t sector_bit = cache_sector_bit(cache, access->address);
+    bool prefetch_hit = false;
+    bool memo_hit = cache_memo_hit(cache, access, block_addr, sector_bit, &prefetch_hit);
+    PROF_END(PROF_FAST_PATH);
+    if (memo_hit) {
+        if (write) cache->writes++;
+        if (write_through) cache_write_through(cache, access);
+        if (cache->prefetcher) cache_prefetch(cache, access, block_addr, true, prefetch_hit);
+        return true;
+    }
 
-    cache_set_t* set = &cache->sets[set_idx];
+    PROF_BEGIN(PROF_ADDR_DECOMPOSE);
+    uint32_t set_idx;
+    uint64_t tag = cache_index_line(cache, slot, block_addr, &set_idx);
+    PROF_END(PROF_ADDR_DECOMPOSE);
 
-    // 1. Check for a Hit
-    uint32_t hit_idx = cache->associativity; // Sentinel value
-    for (uint32_t i = 0; i < set->associativity; i++) {
-        cache_block_t* block = &set->blocks[i];
-        if (block->valid && block->tag == tag) {
-            hit_idx = i;
-            break;
+    uint32_t logical_set = set_idx;
+
+    // Accesses to sets outside the sample are dropped; counts are scaled at report time
+    if (cache->set_map) {
+        set_idx = cache->set_map[set_idx];
+        if (set_idx == UINT32_MAX) {
+            cache->sampled_out++;
+            return false;
         }
     }
+    if (write) cache->writes++; // Like every counter, only for simulated sets
 
-    if (hit_idx < cache->associativity) {
+    cache_set_t* set = &cache->sets[set_idx];
+
+    // 1. Check for a Hit
+    PROF_BEGIN(PROF_TAG_LOOKUP);
+    uint32_t hit_idx = cache->find_way(set, tag);
+    PROF_END(PROF_TAG_LOOKUP);
+
+    if (hit_idx < cache->associativity && (set->blocks[hit_idx].sector_valid & sector_bit)) {
         // HIT: Update statistics and metadata
-        cache->hits++;
-        cache_block_t* block = &set->blocks[hit_idx];
-        
-        // Update access time/count for LRU/LFU
-        block->access_time = set->lru_counter++;
-        block->access_count++;
-        
-        if (access->type == ACCESS_WRITE) block->dirty = true;
+        PROF_BEGIN(PROF_REPLACEMENT_UPDATE);
+        prefetch_hit = cache_demand_hit(cache, set, hit_idx, access, sector_bit);
+        cache_memo_update(cache, access, block_addr, tag, set_idx, hit_idx);
+        PROF_END(PROF_REPLACEMENT_UPDATE);
         
+        if (write_through) cache_write_through(cache, access);
+        if (cache->prefetcher) cache_prefetch(cache, access, block_addr, true, prefetch_hit);
         return true;
     }
 
     // 2. Miss: Go to next level
     cache->misses++;
+    if (cache->slice_misses) cache->slice_misses[slice]++;
+    if (cache->partition) partition_observe(cache->partition, access, block_addr, false);
+    if (write && cache->write_miss == WRITE_NO_ALLOCATE) {
+        // The write goes around this level; nothing is fetched or installed
+        cache->write_no_allocates++;
+        cache_write_through(cache, access);
+        if (cache->prefetcher) cache_prefetch(cache, access, block_addr, false, false);
+        return false;
+    }
+    if (cache->victim && hit_idx == cache->associativity) {
+        hit_idx = cache_victim_swap(cache, set, set_idx, logical_set, tag, access);
+        if (hit_idx < cache->associativity) {
+            if (set->blocks[hit_idx].sector_valid & sector_bit) {
+                // Served by the victim cache: the next level is never asked
+                cache->victim->hits++;
+                cache_touch_block(cache, set, hit_idx, access, sector_bit);
+                cache_memo_update(cache, access, block_addr, tag, set_idx, hit_idx);
+                if (write_through) cache_write_through(cache, access);
+                if (cache->prefetcher) cache_prefetch(cache, access, block_addr, false, false);
+                return true;
+            }
+            cache->victim->partial_hits++; // Swapped back in, the sector still has to be fetched
+        }
+    }
+    cache->bytes_fetched += cache->sector_size;
+    cache_record_miss(cache, access);
+
+    if (hit_idx < cache->associativity) {
+        // Sector miss: the line is resident, only the missing sector is fetched; no victim needed
+        cache->sector_misses++;
+        if (cache->next_level) cache_access(cache->next_level, access);
+
+        set->blocks[hit_idx].sector_valid |= sector_bit;
+        cache_take_handoff(cache, &set->blocks[hit_idx]);
+        cache_touch_block(cache, set, hit_idx, access, sector_bit);
+        cache_memo_update(cache, access, block_addr, tag, set_idx, hit_idx);
+
+        if (cache->prefetcher) cache_prefetch(cache, access, block_addr, false, false);
+        return false;
+    }
 
     // Calculate latency for the fetch from the next level
     uint32_t next_level_latency = 0;
     if (cache->next_level) {
         // Recursive call to access the next level
+        PROF_BEGIN(PROF_NEXT_LEVEL);
         cache_access(cache->next_level, access);
+        PROF_END(PROF_NEXT_LEVEL);
         // The time taken is primarily the latency of the next level plus any additional access time.
         // In this simple model, we assume the cost is the next level's latency.
         next_level_latency = cache->next_level->latency;
@@ -165,33 +1387,96 @@ bool cache_access(cache_layer_t* cache, memory_access_t* access) {
 
     // 3. Eviction/Insertion (if data is not available from lower levels, it's inserted here)
     
-    uint32_t victim_idx = find_victim_block(cache, set_idx);
+    PROF_BEGIN(PROF_VICTIM_SELECT);
+    uint32_t victim_idx = find_victim_block(cache, set_idx, access);
+    PROF_END(PROF_VICTIM_SELECT);
     cache_block_t* victim = &set->blocks[victim_idx];
 
     // Writeback check
-    if (victim->valid && victim->dirty && cache->next_level) {
-        // Writeback the dirty block to the next level
-        cache->evictions++;
-        
-        // This is a simplified writeback access to the next level (not tracked for stats)
-        // A real simulator would perform a separate access here.
-    }
+    cache_evict_block(cache, victim, logical_set, access);
 
     // Install New Block
-    victim->valid = true;
-    victim->tag = tag;
-    victim->dirty = (access->type == ACCESS_WRITE);
-    
-    // Reset metadata for the new block
-    victim->access_time = set->lru_counter++;
-    victim->access_count = 1;
-    
-    // Update FIFO/LRU tracking structures if used for selection
-    if (cache->policy == REPLACEMENT_FIFO) {
-        // Enqueue the new block index
-        queue_enqueue(set->fifo_queue, victim_idx);
-    } 
+    PROF_BEGIN(PROF_REPLACEMENT_UPDATE);
+    cache_fill_block(cache, set, victim_idx, tag, access, sector_bit);
+    cache_take_handoff(cache, victim);
+    cache_memo_update(cache, access, block_addr, tag, set_idx, victim_idx);
+    PROF_END(PROF_REPLACEMENT_UPDATE);
     
+    if (cache->prefetcher) cache_prefetch(cache, access, block_addr, false, false);
+    return false;
+}
+
+void cache_writeback(cache_layer_t* cache, uint64_t address, uint32_t sector_mask, const memory_access_t* origin) {
+    if (!cache) return;
+    sector_mask &= cache_full_line_mask(cache);
+    cache->writebacks_received++;
+
+    cache_block_t* block = cache_lookup(cache, address, NULL);
+    if (block) {
+        // A write-through level keeps its copy clean and passes the data on
+        block->sector_valid |= sector_mask;
+        if (cache->write_hit == WRITE_BACK) {
+            block->dirty = true;
+            block->sector_dirty |= sector_mask;
+            return;
+        }
+    } else if (cache->write_miss == WRITE_ALLOCATE && cache->write_hit == WRITE_BACK) {
+        // The whole dirty payload arrived, so the line is installed without a fetch
+        cache_install_line(cache, address, sector_mask, sector_mask, origin, false);
+        return;
+    }
+
+    if (cache->next_level) {
+        if (cache->miss_stream) miss_stream_record(cache->miss_stream, address, MISS_RECORD_WRITEBACK, origin);
+        cache_writeback(cache->next_level, address, sector_mask, origin);
+    } else if (cache->memory) {
+        dram_write(cache->memory, address, count_bits(sector_mask) * cache->sector_size,
+            cache->clock ? *cache->clock : 0);
+    }
+}
+
+bool cache_warm(cache_layer_t* cache, memory_access_t* access) {
+    return cache_level_warm(cache, access, false);
+}
+
+static bool cache_level_warm(cache_layer_t* cache, memory_access_t* access, bool forwarded) {
+    if (!cache) return false;
+    if (cache->num_shadows) cache_shadow_access(cache, access, true);
+    if (cache->inclusion == INCLUSION_EXCLUSIVE && cache->upper_level && !forwarded) {
+        return cache_exclusive_access(cache, access, true);
+    }
+
+    const cache_line_slot_t* slot = cache_line_slot(cache, access);
+    uint32_t set_idx;
+    uint64_t tag = cache_index_line(cache, slot, cache_line_address(cache, slot, access), &set_idx);
+    uint32_t logical_set = set_idx;
+    if (cache->set_map) {
+        set_idx = cache->set_map[set_idx];
+        if (set_idx == UINT32_MAX) return false;
+    }
+    cache_set_t* set = &cache->sets[set_idx];
+
+    uint32_t sector_bit = cache_sector_bit(cache, access->address);
+    uint32_t way = cache->find_way(set, tag);
+    bool write = access->type == ACCESS_WRITE;
+    if (way < cache->associativity && (set->blocks[way].sector_valid & sector_bit)) {
+        cache_touch_block(cache, set, way, access, sector_bit);
+        if (write && cache->write_hit == WRITE_THROUGH && cache->next_level) cache_level_warm(cache->next_level, access, true);
+        return true;
+    }
+
+    bool no_allocate = write && cache->write_miss == WRITE_NO_ALLOCATE;
+    if (cache->next_level) cache_level_warm(cache->next_level, access, no_allocate);
+    if (no_allocate) return false;
+    if (way == cache->associativity) {
+        way = find_victim_block(cache, set_idx, access);
+        if (set->blocks[way].valid) cache_inclusion_evict(cache, &set->blocks[way], logical_set, access, true);
+        cache_fill_block(cache, set, way, tag, access, sector_bit);
+    } else {
+        set->blocks[way].sector_valid |= sector_bit;
+        cache_touch_block(cache, set, way, access, sector_bit);
+    }
+    cache_take_handoff(cache, &set->blocks[way]);
     return false;
 }
 
@@ -205,28 +1490,167 @@ double get_miss_rate(cache_layer_t* cache) {
     return total == 0 ? 0.0 : (double)cache->misses / total * 100.0;
 }
 
+// Observed over simulated accesses: estimates are the sampled rates applied to every access the
+// layer saw, so they never exceed what actually reached it
+double get_sampling_scale(cache_layer_t* cache) {
+    uint64_t simulated = cache->hits + cache->misses;
+    return simulated ? (double)(simulated + cache->sampled_out) / simulated : 1.0;
+}
+
+uint32_t cache_valid_lines(const cache_layer_t* cache) {
+    uint32_t lines = 0;
+    for (uint32_t s = 0; s < cache->sampled_sets; s++) {
+        for (uint32_t w = 0; w < cache->associativity; w++) lines += cache->sets[s].blocks[w].valid;
+    }
+    return lines;
+}
+
+uint32_t cache_duplicate_lines(const cache_layer_t* upper, const cache_layer_t* lower) {
+    uint32_t duplicates = 0;
+    for (uint32_t logical = 0; logical < upper->num_sets; logical++) {
+        uint32_t s = upper->set_map ? upper->set_map[logical] : logical;
+        if (s == UINT32_MAX) continue;
+        for (uint32_t w = 0; w < upper->associativity; w++) {
+            const cache_block_t* block = &upper->sets[s].blocks[w];
+            if (block->valid && cache_lookup((cache_layer_t*)lower, cache_block_address(upper, block, logical), NULL)) {
+                duplicates++;
+            }
+        }
+    }
+    return duplicates;
+}
+
+// Per-slice load and how unevenly the hash spread it: peak-to-mean ratio and coefficient of variation
+static void cache_print_slice_stats(const cache_layer_t* cache) {
+    uint64_t total = 0, peak = 0;
+    uint32_t busiest = 0;
+    for (uint32_t s = 0; s < cache->num_slices; s++) {
+        total += cache->slice_accesses[s];
+        if (cache->slice_accesses[s] > peak) {
+            peak = cache->slice_accesses[s];
+            busiest = s;
+        }
+    }
+    double mean = (double)total / cache->num_slices;
+    double variance = 0.0;
+    for (uint32_t s = 0; s < cache->num_slices; s++) {
+        double d = cache->slice_accesses[s] - mean;
+        variance += d * d / cache->num_slices;
+    }
+
+    printf("  Slices: %u (%s hash), Peak/Mean Accesses: %.2f (slice %u), CoV: %.3f\n",
+        cache->num_slices, slice_hash_name(cache->slice_hash), mean > 0.0 ? peak / mean : 0.0, busiest,
+        mean > 0.0 ? sqrt(variance) / mean : 0.0);
+    for (uint32_t s = 0; s < cache->num_slices; s++) {
+        uint64_t accesses = cache->slice_accesses[s];
+        printf("    Slice %2u: %10lu accesses (%5.2f%%), Misses: %lu, Miss Rate: %.2f%%\n", s, accesses,
+            total ? (double)accesses / total * 100.0 : 0.0, cache->slice_misses[s],
+            accesses ? (double)cache->slice_misses[s] / accesses * 100.0 : 0.0);
+    }
+}
+
 void print_cache_stats(cache_layer_t* cache) {
     printf("%s Statistics:\n", cache->name);
-    printf("  Size: %u KB, Associativity: %u, Sets: %u\n",
-        cache->size / 1024, cache->associativity, cache->num_sets);
+    printf("  Size: %u KB, Associativity: %u, Sets: %u, Replacement: %s\n",
+        cache->size / 1024, cache->associativity, cache->num_sets, replacement_policy_name(cache->policy));
+    if (cache->policy == REPLACEMENT_DRRIP) {
+        printf("  DRRIP PSEL: %u/%u (followers use %s)\n", cache->psel, DRRIP_PSEL_MAX,
+            cache->psel > DRRIP_PSEL_MAX / 2 ? "BRRIP" : "SRRIP");
+    }
     printf("  Hits: %lu, Misses: %lu\n", cache->hits, cache->misses);
     printf("  Hit Rate:  %.2f%%\n", get_hit_rate(cache));
     printf("  Miss Rate: %.2f%%\n", get_miss_rate(cache));
     printf("  Evictions: %lu\n", cache->evictions);
+    if (cache->sectors_per_line > 1) {
+        printf("  Sectors: %u x %u B, Sector Misses: %lu (%.2f%% of misses)\n",
+            cache->sectors_per_line, cache->sector_size, cache->sector_misses,
+            cache->misses ? (double)cache->sector_misses / cache->misses * 100.0 : 0.0);
+    }
+    printf("  Traffic: %lu bytes fetched, %lu bytes written back, %lu bytes written through\n",
+        cache->bytes_fetched, cache->bytes_written_back, cache->write_through_bytes);
+    printf("  Writes: %lu (%lu hits, %lu not allocated), Write Policy: %s, %s, Writebacks Received: %lu\n",
+        cache->writes, cache->write_hits, cache->write_no_allocates,
+        write_hit_policy_name(cache->write_hit), write_miss_policy_name(cache->write_miss),
+        cache->writebacks_received);
+    printf("  Fast-Path Hits: %lu (%.2f%% of hits)\n", cache->fast_path_hits,
+        cache->hits ? (double)cache->fast_path_hits / cache->hits * 100.0 : 0.0);
+    if (cache->set_sampling != SET_SAMPLING_NONE) {
+        double scale = get_sampling_scale(cache);
+        printf("  Set Sampling: %u of %u sets (%s 1/%u), %lu accesses dropped\n",
+            cache->sampled_sets, cache->num_sets,
+            cache->set_sampling == SET_SAMPLING_HASHED ? "hashed" : "strided",
+            cache->sample_ratio, cache->sampled_out);
+        printf("  Estimated (x%.2f): Hits: %.0f, Misses: %.0f, Evictions: %.0f, Writes: %.0f\n", scale,
+            cache->hits * scale, cache->misses * scale, cache->evictions * scale, cache->writes * scale);
+    }
+    if (cache->inclusion == INCLUSION_INCLUSIVE) {
+        printf("  Back-Invalidations: %lu (%lu dirty)\n", cache->back_invalidations, cache->back_invalidated_dirty);
+    } else if (cache->inclusion == INCLUSION_EXCLUSIVE) {
+        printf("  Victim Fills: %lu\n", cache->victim_fills);
+    }
+    if (cache->victim) victim_cache_print_stats(cache->victim);
+    if (cache->slice_accesses) cache_print_slice_stats(cache);
+    if (cache->partition) {
+        uint32_t occupancy[PARTITION_MAX] = {0};
+        for (uint32_t s = 0; s < cache->sampled_sets; s++) {
+            for (uint32_t w = 0; w < cache->associativity; w++) {
+                const cache_block_t* block = &cache->sets[s].blocks[w];
+                if (block->valid) occupancy[block->owner]++;
+            }
+        }
+        partition_print_stats(cache->partition, occupancy, cache->sampled_sets * cache->associativity);
+    }
+    if (cache->num_shadows) {
+        // Estimates shift each shadow by the baseline's sampling error
+        double real = get_hit_rate(cache);
+        double error = real - get_hit_rate(cache->shadows[0]);
+        printf("  Shadow Tags (%u of %u sets): %s baseline %.2f%% (real %.2f%%)\n",
+            cache->shadows[0]->sampled_sets, cache->num_sets, cache->shadows[0]->name,
+            get_hit_rate(cache->shadows[0]), real);
+        for (uint32_t i = 1; i < cache->num_shadows; i++) {
+            double estimate = get_hit_rate(cache->shadows[i]) + error;
+            if (estimate < 0.0) estimate = 0.0;
+            if (estimate > 100.0) estimate = 100.0;
+            printf("    %-16s sampled %.2f%%, est. hit rate %.2f%% (%+.2f)\n", cache->shadows[i]->name,
+                get_hit_rate(cache->shadows[i]), estimate, estimate - real);
+        }
+    }
+    if (cache->prefetcher) {
+        uint64_t used = cache->prefetch_useful + cache->prefetch_late;
+        printf("  Prefetcher: %s (degree %u)\n", prefetcher_name(cache->prefetcher->type), cache->prefetcher->degree);
+        printf("  Prefetch Fills: %lu of %lu requests (%lu from memory)\n",
+            cache->prefetch_fills, cache->prefetch_requests, cache->prefetch_memory_fills);
+        printf("  Prefetch Useful: %lu, Late: %lu, Useless: %lu\n",
+            cache->prefetch_useful, cache->prefetch_late, cache->prefetch_useless);
+        printf("  Prefetch Accuracy: %.2f%%, Coverage: %.2f%%\n",
+            cache->prefetch_fills ? (double)used / cache->prefetch_fills * 100.0 : 0.0,
+            used + cache->misses ? (double)used / (used + cache->misses) * 100.0 : 0.0);
+    }
     printf("  Latency: %u cycles\n\n", cache->latency);
 }
 
 void cache_layer_free(cache_layer_t* cache) {
     if (!cache) return;
     
-    for (uint32_t i = 0; i < cache->num_sets; i++) {
+    for (uint32_t i = 0; i < cache->sampled_sets; i++) {
         free(cache->sets[i].blocks);
         if (cache->sets[i].fifo_queue) queue_free(cache->sets[i].fifo_queue);
         if (cache->sets[i].lru_deque) deque_free(cache->sets[i].lru_deque);
         if (cache->sets[i].lfu_heap) pq_free(cache->sets[i].lfu_heap);
+        if (cache->sets[i].directory) hash_table_free(cache->sets[i].directory);
     }
     
     free(cache->sets);
+    free(cache->touched_sets);
+    free(cache->set_map);
+    free(cache->ship_shct);
+    prefetcher_free(cache->prefetcher);
+    partition_free(cache->partition);
+    victim_cache_free(cache->victim);
+    free(cache->slice_accesses);
+    free(cache->slice_misses);
+    free(cache->line_slots);
+    for (uint32_t i = 0; i < cache->num_shadows; i++) cache_layer_free(cache->shadows[i]);
     if (cache->tag_table) hash_table_free(cache->tag_table);
     free(cache);
 }
@@ -0,0 +1,655 @@
+#define _POSIX_C_SOURCE 200809L
+#include "checkpoint.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#define CHECKPOINT_FLAG_VALID 0x1
+#define CHECKPOINT_FLAG_DIRTY 0x2
+#define CHECKPOINT_FLAG_PREFETCHED 0x4
+
+#define CHECKPOINT_MAX_LAYERS (2 + MAX_BLOCKS + 2)
+
+// Layers in the order they appear in the file: L1, L2, then the TLBs and walk cache if translating
+static uint32_t checkpoint_layers(gpu_memory_system_t* system, cache_layer_t** layers) {
+    uint32_t n = 0;
+    layers[n++] = system->l1_cache;
+    layers[n++] = system->l2_cache;
+    if (system->mmu) {
+        for (uint32_t i = 0; i < MAX_BLOCKS; i++) layers[n++] = system->mmu->l1_tlbs[i];
+        layers[n++] = system->mmu->l2_tlb;
+        if (system->mmu->pwc) layers[n++] = system->mmu->pwc;
+    }
+    return n;
+}
+
+// --- Writer ---
+
+static void write_bytes(FILE* file, const void* data, size_t len, bool* ok) {
+    if (*ok && fwrite(data, 1, len, file) != len) *ok = false;
+}
+
+static void write_u8(FILE* file, uint8_t value, bool* ok) { write_bytes(file, &value, sizeof(value), ok); }
+static void write_u32(FILE* file, uint32_t value, bool* ok) { write_bytes(file, &value, sizeof(value), ok); }
+static void write_u64(FILE* file, uint64_t value, bool* ok) { write_bytes(file, &value, sizeof(value), ok); }
+
+// Partition setup (checked on restore), then quotas, counters and utility monitors
+static void write_partition(FILE* file, partition_t* part, bool* ok) {
+    write_u32(file, part ? part->count : 0, ok);
+    if (!part) return;
+    write_u32(file, (uint32_t)part->key, ok);
+    write_u32(file, part->interval, ok);
+    for (uint32_t p = 0; p < part->count; p++) {
+        write_u32(file, part->ways[p], ok);
+        write_u64(file, part->hits[p], ok);
+        write_u64(file, part->misses[p], ok);
+    }
+    write_u64(file, part->since_repartition, ok);
+    write_u64(file, part->repartitions, ok);
+    if (part->interval) {
+        write_bytes(file, part->umon_tags, (size_t)part->count * part->umon_sets * part->associativity * sizeof(uint64_t), ok);
+        write_bytes(file, part->umon_hits, (size_t)part->count * part->associativity * sizeof(uint64_t), ok);
+    }
+}
+
+// Victim cache capacity (checked on restore), counters, then its lines from LRU to MRU
+static void write_victim_cache(FILE* file, victim_cache_t* vc, bool* ok) {
+    write_u32(file, vc ? vc->capacity : 0, ok);
+    if (!vc) return;
+    write_u64(file, vc->probes, ok);
+    write_u64(file, vc->hits, ok);
+    write_u64(file, vc->partial_hits, ok);
+    write_u64(file, vc->inserts, ok);
+    write_u64(file, vc->evictions, ok);
+    write_u64(file, vc->dirty_evictions, ok);
+    write_u64(file, vc->invalidations, ok);
+    write_u32(file, vc->count, ok);
+    for (uint32_t i = vc->lru; i != VICTIM_NONE; i = vc->entries[i].prev) {
+        write_u64(file, vc->entries[i].line, ok);
+        write_u32(file, vc->entries[i].sector_valid, ok);
+        write_u32(file, vc->entries[i].sector_dirty, ok);
+    }
+}
+
+static void write_layer(FILE* file, cache_layer_t* cache, bool* ok) {
+    write_u32(file, cache->num_sets, ok);
+    write_u32(file, cache->sampled_sets, ok);
+    write_u32(file, cache->associativity, ok);
+    write_u32(file, cache->block_size, ok);
+    write_u32(file, cache->sector_size, ok);
+    write_u32(file, (uint32_t)cache->policy, ok);
+    write_u32(file, (uint32_t)cache->inclusion, ok);
+    write_u32(file, (uint32_t)cache->write_hit, ok);
+    write_u32(file, (uint32_t)cache->write_miss, ok);
+    write_u32(file, cache->num_slices, ok);
+    write_u32(file, (uint32_t)cache->slice_hash, ok);
+    write_u64(file, cache->hits, ok);
+    write_u64(file, cache->misses, ok);
+    write_u64(file, cache->evictions, ok);
+    write_u64(file, cache->sector_misses, ok);
+    write_u64(file, cache->bytes_fetched, ok);
+    write_u64(file, cache->bytes_written_back, ok);
+    write_u64(file, cache->sampled_out, ok);
+    write_u64(file, cache->fast_path_hits, ok);
+    write_u64(file, cache->prefetch_requests, ok);
+    write_u64(file, cache->prefetch_fills, ok);
+    write_u64(file, cache->prefetch_memory_fills, ok);
+    write_u64(file, cache->prefetch_useful, ok);
+    write_u64(file, cache->prefetch_late, ok);
+    write_u64(file, cache->prefetch_useless, ok);
+    write_u64(file, cache->back_invalidations, ok);
+    write_u64(file, cache->back_invalidated_dirty, ok);
+    write_u64(file, cache->victim_fills, ok);
+    write_u64(file, cache->writes, ok);
+    write_u64(file, cache->write_hits, ok);
+    write_u64(file, cache->write_no_allocates, ok);
+    write_u64(file, cache->write_through_bytes, ok);
+    write_u64(file, cache->writebacks_received, ok);
+    write_u32(file, cache->psel, ok);
+    write_u32(file, cache->brrip_fills, ok);
+    // The fast-path memo, so memo hits after a restore match an uninterrupted run
+    write_bytes(file, cache->memo_block_addr, sizeof(cache->memo_block_addr), ok);
+    write_bytes(file, cache->memo_tag, sizeof(cache->memo_tag), ok);
+    write_bytes(file, cache->memo_set, sizeof(cache->memo_set), ok);
+    write_bytes(file, cache->memo_way, sizeof(cache->memo_way), ok);
+    write_u32(file, cache->prefetcher ? (uint32_t)cache->prefetcher->type : PREFETCH_NONE, ok);
+    write_u32(file, cache->prefetcher ? cache->prefetcher->degree : 0, ok);
+    if (cache->prefetcher) write_bytes(file, cache->prefetcher->state, prefetcher_state_size(cache->prefetcher), ok);
+    if (cache->ship_shct) write_bytes(file, cache->ship_shct, 1u << SHIP_SIGNATURE_BITS, ok);
+    if (cache->slice_accesses) {
+        write_bytes(file, cache->slice_accesses, cache->num_slices * sizeof(uint64_t), ok);
+        write_bytes(file, cache->slice_misses, cache->num_slices * sizeof(uint64_t), ok);
+    }
+    write_partition(file, cache->partition, ok);
+    write_victim_cache(file, cache->victim, ok);
+
+    for (uint32_t s = 0; s < cache->sampled_sets; s++) {
+        cache_set_t* set = &cache->sets[s];
+        write_u32(file, set->lru_counter, ok);
+        write_u64(file, set->rrpv, ok);
+        write_u32(file, set->reused, ok);
+
+        // FIFO order is the only replacement state held outside the blocks
+        uint32_t fifo_size = set->fifo_queue ? set->fifo_queue->size : 0;
+        write_u32(file, fifo_size, ok);
+        for (queue_node_t* node = fifo_size ? set->fifo_queue->front : NULL; node; node = node->next) {
+            write_u32(file, node->data, ok);
+        }
+
+        for (uint32_t w = 0; w < set->associativity; w++) {
+            cache_block_t* block = &set->blocks[w];
+            write_u64(file, block->tag, ok);
+            write_u32(file, block->access_time, ok);
+            write_u32(file, block->access_count, ok);
+            write_u32(file, block->sector_valid, ok);
+            write_u32(file, block->sector_dirty, ok);
+            write_u32(file, block->signature, ok);
+            write_u8(file, block->owner, ok);
+            write_u8(file, (block->valid ? CHECKPOINT_FLAG_VALID : 0) |
+                           (block->dirty ? CHECKPOINT_FLAG_DIRTY : 0) |
+                           (block->prefetched ? CHECKPOINT_FLAG_PREFETCHED : 0), ok);
+        }
+    }
+
+    write_u32(file, cache->num_shadows, ok);
+    for (uint32_t i = 0; i < cache->num_shadows; i++) write_layer(file, cache->shadows[i], ok);
+}
+
+static void write_scratchpad(FILE* file, scratchpad_t* sp, bool* ok) {
+    write_u64(file, sp->accesses, ok);
+    write_u64(file, sp->requests, ok);
+    write_u64(file, sp->broadcasts, ok);
+    write_u64(file, sp->conflict_cycles, ok);
+    write_u64(file, sp->degree_sum, ok);
+    for (uint32_t d = 0; d <= SCRATCHPAD_BANKS; d++) write_u64(file, sp->histogram[d], ok);
+
+    // Warp requests still being assembled, so a resumed run groups lanes exactly as before
+    for (uint32_t b = 0; b < MAX_BLOCKS; b++) {
+        scratchpad_request_t* req = &sp->pending[b];
+        write_u8(file, req->open, ok);
+        if (!req->open) continue;
+        write_u32(file, req->warp, ok);
+        write_u8(file, (uint8_t)req->type, ok);
+        write_u32(file, req->lanes, ok);
+        write_u32(file, req->num_words, ok);
+        for (uint32_t i = 0; i < req->num_words; i++) write_u64(file, req->words[i], ok);
+    }
+}
+
+static void write_dram(FILE* file, dram_t* dram, bool* ok) {
+    write_u32(file, dram->config.channels, ok);
+    write_u32(file, dram->config.banks, ok);
+    write_u32(file, (uint32_t)dram->config.mapping, ok);
+    write_u64(file, dram->reads, ok);
+    write_u64(file, dram->writes, ok);
+    write_u64(file, dram->bytes, ok);
+    write_u64(file, dram->row_hits, ok);
+    write_u64(file, dram->row_misses, ok);
+    write_u64(file, dram->row_conflicts, ok);
+    write_u64(file, dram->read_latency, ok);
+    write_u64(file, dram->queue_cycles, ok);
+
+    // Open rows and busy times, so a resumed run sees the same row hits and conflicts
+    for (uint32_t c = 0; c < dram->config.channels; c++) {
+        dram_channel_t* ch = &dram->channels[c];
+        write_u64(file, ch->bus_ready, ok);
+        write_u64(file, ch->requests, ok);
+        write_u64(file, ch->bus_cycles, ok);
+        for (uint32_t b = 0; b < dram->config.banks; b++) {
+            write_u8(file, ch->banks[b].open, ok);
+            write_u64(file, ch->banks[b].row, ok);
+            write_u64(file, ch->banks[b].ready, ok);
+        }
+    }
+}
+
+// Translation setup (checked on restore) and counters; the TLBs are saved as layers
+static void write_mmu(FILE* file, mmu_t* mmu, bool* ok) {
+    write_u8(file, mmu != NULL, ok);
+    if (!mmu) return;
+    write_u32(file, (uint32_t)mmu->config.page_size, ok);
+    write_u32(file, mmu->config.num_regions, ok);
+    write_u64(file, mmu->translations, ok);
+    for (uint32_t p = 0; p < PAGE_SIZE_CLASSES; p++) write_u64(file, mmu->page_translations[p], ok);
+    write_u64(file, mmu->walks, ok);
+    write_u64(file, mmu->walk_reads, ok);
+    write_u64(file, mmu->walk_cycles, ok);
+    write_u64(file, mmu->translation_cycles, ok);
+}
+
+int checkpoint_save(const char* path, gpu_memory_system_t* system, uint64_t trace_offset) {
+    if (!path || !system) return -1;
+
+    char tmp_path[1024];
+    snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", path);
+
+    FILE* file = fopen(tmp_path, "wb");
+    if (!file) {
+        printf("Error: Cannot open checkpoint file %s for writing\n", tmp_path);
+        return -1;
+    }
+
+    cache_layer_t* layers[CHECKPOINT_MAX_LAYERS];
+    uint32_t num_layers = checkpoint_layers(system, layers);
+
+    bool ok = true;
+    write_u32(file, CHECKPOINT_MAGIC, &ok);
+    write_u32(file, CHECKPOINT_VERSION, &ok);
+    write_u64(file, trace_offset, &ok);
+    write_u64(file, system->total_accesses, &ok);
+    write_u64(file, system->register_hits, &ok);
+    write_u64(file, system->global_memory_accesses, &ok);
+    write_u64(file, system->total_latency, &ok);
+    write_u64(file, system->current_cycle, &ok);
+    write_u64(file, system->l2_sampled_cycles, &ok);
+    write_u64(file, system->l2_sampled_misses, &ok);
+    write_u64(file, system->l2_estimated_accesses, &ok);
+    write_scratchpad(file, system->shared_memory, &ok);
+    write_dram(file, system->dram, &ok);
+    write_mmu(file, system->mmu, &ok);
+    write_u32(file, num_layers, &ok);
+
+    for (uint32_t i = 0; i < num_layers; i++) write_layer(file, layers[i], &ok);
+
+    if (fclose(file) != 0) ok = false;
+    if (!ok || rename(tmp_path, path) != 0) {
+        printf("Error: Failed to write checkpoint %s\n", path);
+        remove(tmp_path);
+        return -1;
+    }
+    return 0;
+}
+
+// --- Reader ---
+
+typedef struct {
+    const uint8_t* pos;
+    const uint8_t* end;
+    bool ok;
+} checkpoint_cursor_t;
+
+static void read_bytes(checkpoint_cursor_t* cur, void* out, size_t len) {
+    if (!cur->ok || (size_t)(cur->end - cur->pos) < len) {
+        cur->ok = false;
+        memset(out, 0, len);
+        return;
+    }
+    memcpy(out, cur->pos, len);
+    cur->pos += len;
+}
+
+static uint8_t read_u8(checkpoint_cursor_t* cur) { uint8_t v; read_bytes(cur, &v, sizeof(v)); return v; }
+static uint32_t read_u32(checkpoint_cursor_t* cur) { uint32_t v; read_bytes(cur, &v, sizeof(v)); return v; }
+static uint64_t read_u64(checkpoint_cursor_t* cur) { uint64_t v; read_bytes(cur, &v, sizeof(v)); return v; }
+
+static bool read_partition(checkpoint_cursor_t* cur, cache_layer_t* cache) {
+    partition_t* part = cache->partition;
+    uint32_t count = read_u32(cur);
+    if (!cur->ok) return false;
+    if (count != (part ? part->count : 0)) {
+        printf("Error: Checkpoint partitioning does not match %s\n", cache->name);
+        return false;
+    }
+    if (!part) return true;
+
+    uint32_t key = read_u32(cur);
+    uint32_t interval = read_u32(cur);
+    if (!cur->ok || key != (uint32_t)part->key || interval != part->interval) {
+        if (cur->ok) printf("Error: Checkpoint partitioning does not match %s\n", cache->name);
+        return false;
+    }
+    uint32_t total = 0;
+    for (uint32_t p = 0; p < part->count; p++) {
+        part->ways[p] = read_u32(cur);
+        part->hits[p] = read_u64(cur);
+        part->misses[p] = read_u64(cur);
+        total += part->ways[p] ? part->ways[p] : part->associativity + 1;
+    }
+    if (cur->ok && total != part->associativity) {
+        printf("Error: Checkpoint way split is invalid for %s\n", cache->name);
+        return false;
+    }
+    part->since_repartition = read_u64(cur);
+    part->repartitions = read_u64(cur);
+    if (part->interval) {
+        read_bytes(cur, part->umon_tags, (size_t)part->count * part->umon_sets * part->associativity * sizeof(uint64_t));
+        read_bytes(cur, part->umon_hits, (size_t)part->count * part->associativity * sizeof(uint64_t));
+    }
+
+    partition_build_masks(part);
+    return cur->ok;
+}
+
+static bool read_victim_cache(checkpoint_cursor_t* cur, cache_layer_t* cache) {
+    victim_cache_t* vc = cache->victim;
+    uint32_t capacity = read_u32(cur);
+    if (!cur->ok) return false;
+    if (capacity != (vc ? vc->capacity : 0)) {
+        printf("Error: Checkpoint victim cache does not match %s\n", cache->name);
+        return false;
+    }
+    if (!vc) return true;
+
+    uint64_t counters[7];
+    for (uint32_t i = 0; i < 7; i++) counters[i] = read_u64(cur);
+    uint32_t count = read_u32(cur);
+    if (cur->ok && count > capacity) {
+        printf("Error: Checkpoint victim cache holds too many lines for %s\n", cache->name);
+        return false;
+    }
+
+    // Lines are stored LRU first, so inserting them in file order rebuilds the same recency
+    victim_cache_clear(vc);
+    for (uint32_t i = 0; i < count && cur->ok; i++) {
+        victim_entry_t entry;
+        entry.line = read_u64(cur);
+        entry.sector_valid = read_u32(cur);
+        entry.sector_dirty = read_u32(cur);
+        victim_cache_insert(vc, entry.line, entry.sector_valid, entry.sector_dirty, &entry);
+    }
+    if (!cur->ok) return false;
+
+    vc->probes = counters[0];
+    vc->hits = counters[1];
+    vc->partial_hits = counters[2];
+    vc->inserts = counters[3];
+    vc->evictions = counters[4];
+    vc->dirty_evictions = counters[5];
+    vc->invalidations = counters[6];
+    return true;
+}
+
+static bool read_layer(checkpoint_cursor_t* cur, cache_layer_t* cache) {
+    uint32_t num_sets = read_u32(cur);
+    uint32_t sampled_sets = read_u32(cur);
+    uint32_t associativity = read_u32(cur);
+    uint32_t block_size = read_u32(cur);
+    uint32_t sector_size = read_u32(cur);
+    uint32_t policy = read_u32(cur);
+    uint32_t inclusion = read_u32(cur);
+    uint32_t write_hit = read_u32(cur);
+    uint32_t write_miss = read_u32(cur);
+    uint32_t num_slices = read_u32(cur);
+    uint32_t slice_hash = read_u32(cur);
+
+    if (!cur->ok) return false;
+    if (num_sets != cache->num_sets || sampled_sets != cache->sampled_sets || associativity != cache->associativity ||
+        block_size != cache->block_size || sector_size != cache->sector_size || policy != (uint32_t)cache->policy ||
+        inclusion != (uint32_t)cache->inclusion || write_hit != (uint32_t)cache->write_hit ||
+        write_miss != (uint32_t)cache->write_miss || num_slices != cache->num_slices ||
+        slice_hash != (uint32_t)cache->slice_hash) {
+        printf("Error: Checkpoint geometry does not match %s\n", cache->name);
+        return false;
+    }
+
+    cache->hits = read_u64(cur);
+    cache->misses = read_u64(cur);
+    cache->evictions = read_u64(cur);
+    cache->sector_misses = read_u64(cur);
+    cache->bytes_fetched = read_u64(cur);
+    cache->bytes_written_back = read_u64(cur);
+    cache->sampled_out = read_u64(cur);
+    cache->fast_path_hits = read_u64(cur);
+    cache->prefetch_requests = read_u64(cur);
+    cache->prefetch_fills = read_u64(cur);
+    cache->prefetch_memory_fills = read_u64(cur);
+    cache->prefetch_useful = read_u64(cur);
+    cache->prefetch_late = read_u64(cur);
+    cache->prefetch_useless = read_u64(cur);
+    cache->back_invalidations = read_u64(cur);
+    cache->back_invalidated_dirty = read_u64(cur);
+    cache->victim_fills = read_u64(cur);
+    cache->writes = read_u64(cur);
+    cache->write_hits = read_u64(cur);
+    cache->write_no_allocates = read_u64(cur);
+    cache->write_through_bytes = read_u64(cur);
+    cache->writebacks_received = read_u64(cur);
+    cache->psel = read_u32(cur);
+    cache->brrip_fills = read_u32(cur);
+    read_bytes(cur, cache->memo_block_addr, sizeof(cache->memo_block_addr));
+    read_bytes(cur, cache->memo_tag, sizeof(cache->memo_tag));
+    read_bytes(cur, cache->memo_set, sizeof(cache->memo_set));
+    read_bytes(cur, cache->memo_way, sizeof(cache->memo_way));
+    for (uint32_t i = 0; i < CACHE_MEMO_SLOTS; i++) {
+        if (cache->memo_way[i] != UINT32_MAX &&
+            (cache->memo_way[i] >= associativity || cache->memo_set[i] >= sampled_sets)) cur->ok = false;
+    }
+    uint32_t prefetcher = read_u32(cur);
+    uint32_t degree = read_u32(cur);
+    if (cur->ok && (prefetcher != (cache->prefetcher ? (uint32_t)cache->prefetcher->type : PREFETCH_NONE) ||
+                    degree != (cache->prefetcher ? cache->prefetcher->degree : 0))) {
+        printf("Error: Checkpoint prefetcher does not match %s\n", cache->name);
+        return false;
+    }
+    if (cache->prefetcher) read_bytes(cur, cache->prefetcher->state, prefetcher_state_size(cache->prefetcher));
+    if (cache->ship_shct) read_bytes(cur, cache->ship_shct, 1u << SHIP_SIGNATURE_BITS);
+    if (cache->slice_accesses) {
+        read_bytes(cur, cache->slice_accesses, cache->num_slices * sizeof(uint64_t));
+        read_bytes(cur, cache->slice_misses, cache->num_slices * sizeof(uint64_t));
+    }
+    if (!read_partition(cur, cache)) return false;
+    if (!read_victim_cache(cur, cache)) return false;
+
+    for (uint32_t s = 0; s < sampled_sets && cur->ok; s++) {
+        cache_set_t* set = &cache->sets[s];
+        set->lru_counter = read_u32(cur);
+        set->rrpv = read_u64(cur);
+        set->reused = read_u32(cur);
+
+        // Way, partition and signature indices are checked before anything is queued or installed
+        uint32_t fifo_size = read_u32(cur);
+        const uint8_t* fifo_ways = cur->pos;
+        bool corrupt = fifo_size > associativity;
+        for (uint32_t i = 0; i < fifo_size && !corrupt && cur->ok; i++) corrupt = read_u32(cur) >= associativity;
+        if (!corrupt && cur->ok && set->fifo_queue) {
+            while (!queue_is_empty(set->fifo_queue)) queue_dequeue(set->fifo_queue);
+            for (uint32_t i = 0; i < fifo_size; i++) {
+                uint32_t way;
+                memcpy(&way, fifo_ways + i * sizeof(way), sizeof(way));
+                queue_enqueue(set->fifo_queue, way);
+            }
+        }
+
+        uint32_t owners = cache->partition ? cache->partition->count : 1;
+        for (uint32_t w = 0; w < associativity && !corrupt && cur->ok; w++) {
+            cache_block_t block = set->blocks[w];
+            block.tag = read_u64(cur);
+            block.access_time = read_u32(cur);
+            block.access_count = read_u32(cur);
+            block.sector_valid = read_u32(cur);
+            block.sector_dirty = read_u32(cur);
+            uint32_t signature = read_u32(cur);
+            uint8_t owner = read_u8(cur);
+            uint8_t flags = read_u8(cur);
+            if (signature >= 1u << SHIP_SIGNATURE_BITS || owner >= owners) {
+                corrupt = true;
+                break;
+            }
+            block.signature = (uint16_t)signature;
+            block.owner = owner;
+            block.valid = (flags & CHECKPOINT_FLAG_VALID) != 0;
+            block.dirty = (flags & CHECKPOINT_FLAG_DIRTY) != 0;
+            block.prefetched = (flags & CHECKPOINT_FLAG_PREFETCHED) != 0;
+            block.prefetch_ready = 0; // In-flight prefetches are treated as arrived
+            if (cur->ok) set->blocks[w] = block;
+        }
+        if (corrupt) {
+            printf("Error: Checkpoint set state of %s is corrupt\n", cache->name);
+            return false;
+        }
+    }
+    cache_layer_rebuild_directories(cache);
+
+    if (read_u32(cur) != cache->num_shadows) {
+        if (cur->ok) printf("Error: Checkpoint shadow tags do not match %s\n", cache->name);
+        return false;
+    }
+    for (uint32_t i = 0; i < cache->num_shadows; i++) {
+        if (!read_layer(cur, cache->shadows[i])) return false;
+    }
+    return cur->ok;
+}
+
+static bool read_scratchpad(checkpoint_cursor_t* cur, scratchpad_t* sp) {
+    sp->accesses = read_u64(cur);
+    sp->requests = read_u64(cur);
+    sp->broadcasts = read_u64(cur);
+    sp->conflict_cycles = read_u64(cur);
+    sp->degree_sum = read_u64(cur);
+    for (uint32_t d = 0; d <= SCRATCHPAD_BANKS; d++) sp->histogram[d] = read_u64(cur);
+
+    for (uint32_t b = 0; b < MAX_BLOCKS && cur->ok; b++) {
+        scratchpad_request_t* req = &sp->pending[b];
+        memset(req, 0, sizeof(*req));
+        req->open = read_u8(cur) != 0;
+        if (!req->open) continue;
+
+        req->warp = read_u32(cur);
+        req->type = (access_type_t)read_u8(cur);
+        req->lanes = read_u32(cur);
+        uint32_t num_words = read_u32(cur);
+        if (num_words > SCRATCHPAD_WARP_SIZE) {
+            printf("Error: Checkpoint scratchpad request is corrupt\n");
+            return false;
+        }
+
+        // Passes and bank occupancy follow from the word order
+        for (uint32_t i = 0; i < num_words; i++) {
+            uint64_t word = read_u64(cur);
+            uint32_t pass = ++req->bank_words[word % SCRATCHPAD_BANKS];
+            req->words[i] = word;
+            req->word_pass[i] = (uint8_t)pass;
+            if (pass > req->degree) req->degree = pass;
+        }
+        req->num_words = num_words;
+    }
+    return cur->ok;
+}
+
+static bool read_mmu(checkpoint_cursor_t* cur, mmu_t* mmu) {
+    bool enabled = read_u8(cur) != 0;
+    if (!cur->ok) return false;
+    if (enabled != (mmu != NULL)) {
+        printf("Error: Checkpoint address translation setting does not match\n");
+        return false;
+    }
+    if (!mmu) return true;
+
+    uint32_t page_size = read_u32(cur);
+    uint32_t num_regions = read_u32(cur);
+    if (!cur->ok) return false;
+    if (page_size != (uint32_t)mmu->config.page_size || num_regions != mmu->config.num_regions) {
+        printf("Error: Checkpoint page sizes do not match\n");
+        return false;
+    }
+    mmu->translations = read_u64(cur);
+    for (uint32_t p = 0; p < PAGE_SIZE_CLASSES; p++) mmu->page_translations[p] = read_u64(cur);
+    mmu->walks = read_u64(cur);
+    mmu->walk_reads = read_u64(cur);
+    mmu->walk_cycles = read_u64(cur);
+    mmu->translation_cycles = read_u64(cur);
+    return cur->ok;
+}
+
+static bool read_dram(checkpoint_cursor_t* cur, dram_t* dram) {
+    uint32_t channels = read_u32(cur);
+    uint32_t banks = read_u32(cur);
+    uint32_t mapping = read_u32(cur);
+    if (!cur->ok) return false;
+    if (channels != dram->config.channels || banks != dram->config.banks || mapping != (uint32_t)dram->config.mapping) {
+        printf("Error: Checkpoint DRAM organization does not match\n");
+        return false;
+    }
+
+    dram->reads = read_u64(cur);
+    dram->writes = read_u64(cur);
+    dram->bytes = read_u64(cur);
+    dram->row_hits = read_u64(cur);
+    dram->row_misses = read_u64(cur);
+    dram->row_conflicts = read_u64(cur);
+    dram->read_latency = read_u64(cur);
+    dram->queue_cycles = read_u64(cur);
+
+    for (uint32_t c = 0; c < channels && cur->ok; c++) {
+        dram_channel_t* ch = &dram->channels[c];
+        ch->bus_ready = read_u64(cur);
+        ch->requests = read_u64(cur);
+        ch->bus_cycles = read_u64(cur);
+        for (uint32_t b = 0; b < banks; b++) {
+            ch->banks[b].open = read_u8(cur) != 0;
+            ch->banks[b].row = read_u64(cur);
+            ch->banks[b].ready = read_u64(cur);
+        }
+    }
+    return cur->ok;
+}
+
+int checkpoint_restore(const char* path, gpu_memory_system_t* system, uint64_t* trace_offset) {
+    if (!path || !system) return -1;
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        printf("Error: Cannot open checkpoint file %s\n", path);
+        return -1;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size == 0) {
+        close(fd);
+        printf("Error: Checkpoint file %s is empty\n", path);
+        return -1;
+    }
+
+    void* map = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        printf("Error: Failed to map checkpoint file %s\n", path);
+        return -1;
+    }
+
+    checkpoint_cursor_t cur = { (const uint8_t*)map, (const uint8_t*)map + st.st_size, true };
+    int result = -1;
+
+    uint32_t magic = read_u32(&cur);
+    uint32_t version = read_u32(&cur);
+    if (!cur.ok || magic != CHECKPOINT_MAGIC || version != CHECKPOINT_VERSION) {
+        printf("Error: %s is not a version %d checkpoint\n", path, CHECKPOINT_VERSION);
+        goto done;
+    }
+
+    uint64_t offset = read_u64(&cur);
+    system->total_accesses = read_u64(&cur);
+    system->register_hits = read_u64(&cur);
+    system->global_memory_accesses = read_u64(&cur);
+    system->total_latency = read_u64(&cur);
+    system->current_cycle = read_u64(&cur);
+    system->l2_sampled_cycles = read_u64(&cur);
+    system->l2_sampled_misses = read_u64(&cur);
+    system->l2_estimated_accesses = read_u64(&cur);
+    if (!read_scratchpad(&cur, system->shared_memory)) goto done;
+    if (!read_dram(&cur, system->dram)) goto done;
+    if (!read_mmu(&cur, system->mmu)) goto done;
+
+    cache_layer_t* layers[CHECKPOINT_MAX_LAYERS];
+    uint32_t num_layers = checkpoint_layers(system, layers);
+    if (read_u32(&cur) != num_layers) {
+        printf("Error: Checkpoint layer count does not match the hierarchy\n");
+        goto done;
+    }
+
+    for (uint32_t i = 0; i < num_layers; i++) {
+        if (!read_layer(&cur, layers[i])) goto done;
+    }
+
+    if (trace_offset) *trace_offset = offset;
+    result = 0;
+
+done:
+    if (result != 0 && cur.ok == false) printf("Error: Checkpoint file %s is truncated\n", path);
+    munmap(map, (size_t)st.st_size);
+    return result;
+}
@@ -0,0 +1,282 @@
+#include "dram.h"
+#include "utils.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+void dram_config_default(dram_config_t* config) {
+    config->channels = DRAM_DEFAULT_CHANNELS;
+    config->banks = DRAM_DEFAULT_BANKS;
+    config->row_size = DRAM_DEFAULT_ROW_SIZE;
+    config->bus_bytes = DRAM_DEFAULT_BUS_BYTES;
+    config->t_base = DRAM_DEFAULT_T_BASE;
+    config->t_cas = DRAM_DEFAULT_T_CAS;
+    config->t_rcd = DRAM_DEFAULT_T_RCD;
+    config->t_rp = DRAM_DEFAULT_T_RP;
+    config->mapping = DRAM_MAP_LINE;
+}
+
+const char* dram_mapping_name(dram_mapping_t mapping) {
+    switch (mapping) {
+        case DRAM_MAP_ROW: return "row";
+        case DRAM_MAP_XOR: return "xor";
+        default:           return "line";
+    }
+}
+
+int dram_parse_mapping(const char* name, dram_mapping_t* mapping) {
+    for (int m = DRAM_MAP_LINE; m <= DRAM_MAP_XOR; m++) {
+        if (strcmp(name, dram_mapping_name((dram_mapping_t)m)) == 0) {
+            *mapping = (dram_mapping_t)m;
+            return 0;
+        }
+    }
+    printf("Error: Unknown DRAM mapping '%s' (expected line, row or xor)\n", name);
+    return -1;
+}
+
+dram_t* dram_create(const dram_config_t* config) {
+    if (config->channels == 0 || config->banks == 0 || config->row_size < CACHE_LINE_SIZE || config->bus_bytes == 0) {
+        printf("Error: Invalid DRAM geometry (%u channels, %u banks, %u-byte rows)\n",
+            config->channels, config->banks, config->row_size);
+        return NULL;
+    }
+
+    dram_t* dram = (dram_t*)calloc(1, sizeof(dram_t));
+    if (!dram) return NULL;
+    dram->config = *config;
+
+    dram->channels = (dram_channel_t*)calloc(config->channels, sizeof(dram_channel_t));
+    if (!dram->channels) {
+        free(dram);
+        return NULL;
+    }
+    for (uint32_t c = 0; c < config->channels; c++) {
+        dram->channels[c].banks = (dram_bank_t*)calloc(config->banks, sizeof(dram_bank_t));
+        if (!dram->channels[c].banks) {
+            dram_free(dram);
+            return NULL;
+        }
+    }
+    return dram;
+}
+
+// --- Address Mapping ---
+
+static void dram_map(const dram_t* dram, uint64_t address, uint32_t* channel, uint32_t* bank, uint64_t* row) {
+    const dram_config_t* cfg = &dram->config;
+    uint64_t line = address / CACHE_LINE_SIZE;
+    uint64_t lines_per_row = cfg->row_size / CACHE_LINE_SIZE;
+
+    if (cfg->mapping == DRAM_MAP_ROW) {
+        line /= lines_per_row;
+        *channel = (uint32_t)(line % cfg->channels);
+        line /= cfg->channels;
+    } else {
+        *channel = (uint32_t)(line % cfg->channels);
+        line /= cfg->channels;
+        line /= lines_per_row;
+    }
+    *bank = (uint32_t)(line % cfg->banks);
+    *row = line / cfg->banks;
+
+    // Permutation-based interleaving: rows that would collide in one bank land in different banks
+    if (cfg->mapping == DRAM_MAP_XOR) *bank = (uint32_t)((*bank ^ *row) % cfg->banks);
+}
+
+// --- Service ---
+
+static inline uint64_t max_u64(uint64_t a, uint64_t b) { return a > b ? a : b; }
+
+// Row buffer + bus timing for one request whose first command may go out at cycle start.
+// Returns the cycle its last data beat leaves the channel.
+static uint64_t dram_service(dram_t* dram, uint32_t channel, uint32_t bank_idx, uint64_t row,
+                             uint32_t bytes, uint64_t start) {
+    const dram_config_t* cfg = &dram->config;
+    dram_channel_t* ch = &dram->channels[channel];
+    dram_bank_t* bank = &ch->banks[bank_idx];
+
+    uint32_t access = cfg->t_cas;
+    if (bank->open && bank->row == row) {
+        dram->row_hits++;
+    } else if (!bank->open) {
+        dram->row_misses++;
+        access += cfg->t_rcd;
+    } else {
+        dram->row_conflicts++;
+        access += cfg->t_rp + cfg->t_rcd;
+    }
+    bank->open = true;
+    bank->row = row;
+
+    uint32_t burst = (bytes + cfg->bus_bytes - 1) / cfg->bus_bytes;
+    uint64_t command = max_u64(start, bank->ready);
+    uint64_t data = max_u64(command + access, ch->bus_ready);
+    ch->bus_ready = data + burst;
+    bank->ready = data + burst; // The bank is held until its data has been transferred
+
+    ch->requests++;
+    ch->bus_cycles += burst;
+    dram->bytes += bytes;
+    dram->queue_cycles += command - start;
+    return data + burst;
+}
+
+uint64_t dram_read(dram_t* dram, uint64_t address, uint32_t bytes, uint64_t now) {
+    uint32_t channel, bank;
+    uint64_t row;
+    dram_map(dram, address, &channel, &bank, &row);
+
+    uint64_t done = dram_service(dram, channel, bank, row, bytes, now) + dram->config.t_base;
+    dram->reads++;
+    dram->read_latency += done - now;
+    return done;
+}
+
+void dram_write(dram_t* dram, uint64_t address, uint32_t bytes, uint64_t now) {
+    uint32_t channel, bank;
+    uint64_t row;
+    dram_map(dram, address, &channel, &bank, &row);
+
+    uint64_t queued = dram->queue_cycles;
+    dram_service(dram, channel, bank, row, bytes, now);
+    dram->queue_cycles = queued; // Posted: the delay is nobody's latency
+    dram->writes++;
+}
+
+// --- FR-FCFS Queue ---
+
+int dram_enqueue(dram_t* dram, uint64_t address, uint32_t bytes, uint64_t arrival, uint32_t tag) {
+    uint32_t channel, bank;
+    uint64_t row;
+    dram_map(dram, address, &channel, &bank, &row);
+
+    dram_channel_t* ch = &dram->channels[channel];
+    if (ch->queued == ch->queue_capacity) {
+        uint32_t capacity = ch->queue_capacity ? ch->queue_capacity * 2 : 16;
+        dram_request_t* queue = (dram_request_t*)realloc(ch->queue, capacity * sizeof(dram_request_t));
+        if (!queue) {
+            printf("Error: Failed to grow DRAM request queue\n");
+            return -1;
+        }
+        ch->queue = queue;
+        ch->queue_capacity = capacity;
+    }
+
+    dram_request_t* req = &ch->queue[ch->queued++];
+    req->arrival = arrival;
+    req->row = row;
+    req->bank = bank;
+    req->bytes = bytes;
+    req->tag = tag;
+    return (int)channel;
+}
+
+bool dram_schedule(dram_t* dram, uint32_t channel, uint64_t now, uint32_t* tag, uint64_t* done) {
+    dram_channel_t* ch = &dram->channels[channel];
+    int32_t oldest = -1, oldest_hit = -1;
+
+    // Candidates: arrived, and their bank can take a command now
+    for (uint32_t i = 0; i < ch->queued; i++) {
+        dram_request_t* r = &ch->queue[i];
+        dram_bank_t* bank = &ch->banks[r->bank];
+        if (r->arrival > now || bank->ready > now) continue;
+
+        if (oldest < 0 || r->arrival < ch->queue[oldest].arrival) oldest = (int32_t)i;
+        if (bank->open && bank->row == r->row &&
+            (oldest_hit < 0 || r->arrival < ch->queue[oldest_hit].arrival)) oldest_hit = (int32_t)i;
+    }
+    if (oldest < 0) return false;
+
+    // First-ready (row hit) first, unless the oldest request has starved
+    int32_t pick = oldest;
+    if (oldest_hit >= 0 && now - ch->queue[oldest].arrival < DRAM_STARVATION_CYCLES) pick = oldest_hit;
+
+    dram_request_t req = ch->queue[pick];
+    ch->queue[pick] = ch->queue[--ch->queued];
+
+    // Cycles spent queued before this decision count as queueing delay too
+    dram->queue_cycles += now - req.arrival;
+    *done = dram_service(dram, channel, req.bank, req.row, req.bytes, now) + dram->config.t_base;
+    *tag = req.tag;
+    dram->reads++;
+    dram->read_latency += *done - req.arrival;
+    return true;
+}
+
+uint64_t dram_next_decision(dram_t* dram, uint32_t channel) {
+    dram_channel_t* ch = &dram->channels[channel];
+    uint64_t next = UINT64_MAX;
+    for (uint32_t i = 0; i < ch->queued; i++) {
+        dram_request_t* r = &ch->queue[i];
+        uint64_t ready = max_u64(r->arrival, ch->banks[r->bank].ready);
+        if (ready < next) next = ready;
+    }
+    return next;
+}
+
+// --- Reporting ---
+
+void dram_print_stats(dram_t* dram, uint64_t elapsed_cycles) {
+    const dram_config_t* cfg = &dram->config;
+    uint64_t requests = dram->row_hits + dram->row_misses + dram->row_conflicts;
+    double elapsed = elapsed_cycles ? (double)elapsed_cycles : 1.0;
+
+    printf("DRAM Statistics:\n");
+    printf("  Channels: %u, Banks/Channel: %u, Row: %u B, Mapping: %s\n",
+        cfg->channels, cfg->banks, cfg->row_size, dram_mapping_name(cfg->mapping));
+    printf("  Timing: tCAS %u, tRCD %u, tRP %u, base %u, bus %u B/cycle\n",
+        cfg->t_cas, cfg->t_rcd, cfg->t_rp, cfg->t_base, cfg->bus_bytes);
+    printf("  Requests: %lu (%lu reads, %lu writes), %lu bytes\n", requests, dram->reads, dram->writes, dram->bytes);
+    if (requests > 0) {
+        printf("  Row Hits: %lu (%.2f%%), Row Misses: %lu (%.2f%%), Row Conflicts: %lu (%.2f%%)\n",
+            dram->row_hits, (double)dram->row_hits / requests * 100.0,
+            dram->row_misses, (double)dram->row_misses / requests * 100.0,
+            dram->row_conflicts, (double)dram->row_conflicts / requests * 100.0);
+    }
+    if (dram->reads > 0) {
+        printf("  Avg Read Latency: %.2f cycles (%.2f queued)\n",
+            (double)dram->read_latency / dram->reads, (double)dram->queue_cycles / dram->reads);
+    }
+
+    uint64_t max_requests = 0;
+    for (uint32_t c = 0; c < cfg->channels; c++) {
+        if (dram->channels[c].requests > max_requests) max_requests = dram->channels[c].requests;
+    }
+    printf("  Channel Load (requests, bus utilization):\n");
+    for (uint32_t c = 0; c < cfg->channels; c++) {
+        dram_channel_t* ch = &dram->channels[c];
+        printf("    Ch %2u: %8lu (%5.2f%%) %5.2f%%\n", c, ch->requests,
+            requests ? (double)ch->requests / requests * 100.0 : 0.0, ch->bus_cycles / elapsed * 100.0);
+    }
+    if (requests > 0) {
+        printf("  Load Imbalance (max/avg): %.2f\n", (double)max_requests * cfg->channels / requests);
+    }
+    printf("\n");
+}
+
+void dram_reset(dram_t* dram) {
+    if (!dram) return;
+    for (uint32_t c = 0; c < dram->config.channels; c++) {
+        dram_channel_t* ch = &dram->channels[c];
+        memset(ch->banks, 0, dram->config.banks * sizeof(dram_bank_t));
+        ch->bus_ready = 0;
+        ch->queued = 0;
+        ch->requests = ch->bus_cycles = 0;
+    }
+    dram->reads = dram->writes = dram->bytes = 0;
+    dram->row_hits = dram->row_misses = dram->row_conflicts = 0;
+    dram->read_latency = dram->queue_cycles = 0;
+}
+
+void dram_free(dram_t* dram) {
+    if (!dram) return;
+    if (dram->channels) {
+        for (uint32_t c = 0; c < dram->config.channels; c++) {
+            free(dram->channels[c].banks);
+            free(dram->channels[c].queue);
+        }
+        free(dram->channels);
+    }
+    free(dram);
+}
@@ -1,11 +1,129 @@
 #include "gpu_memory_system.h"
+#include "profiler.h"
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
 
+void gpu_system_config_default(gpu_system_config_t* config) {
+    memset(config, 0, sizeof(*config)); // Configurations are compared bytewise (see server.c)
+    config->l1_policy = REPLACEMENT_LRU;
+    config->l2_policy = REPLACEMENT_LRU;
+    config->l2_size = L2_CACHE_SIZE;
+    config->l2_associativity = L2_ASSOCIATIVITY;
+    config->l2_set_sampling = SET_SAMPLING_NONE;
+    config->l2_sample_ratio = 1;
+    config->l1_prefetcher = PREFETCH_NONE;
+    config->l1_prefetch_degree = PREFETCH_DEFAULT_DEGREE;
+    config->l2_prefetcher = PREFETCH_NONE;
+    config->l2_prefetch_degree = PREFETCH_DEFAULT_DEGREE;
+    config->sector_size = 0;
+    config->inclusion = INCLUSION_NINE;
+    config->l1_write_hit = WRITE_THROUGH;
+    config->l1_write_miss = WRITE_NO_ALLOCATE;
+    config->l2_write_hit = WRITE_BACK;
+    config->l2_write_miss = WRITE_ALLOCATE;
+    config->l2_shadows = 0;
+    config->l2_partitions = 0;
+    config->l2_partition_key = PARTITION_BY_BLOCK;
+    memset(config->l2_partition_ways, 0, sizeof(config->l2_partition_ways));
+    config->l2_partition_split = false;
+    config->l2_ucp_interval = 0;
+    config->l2_slices = 1;
+    config->l2_slice_hash = SLICE_HASH_XOR;
+    config->l1_victim_entries = 0;
+    dram_config_default(&config->dram);
+    mmu_config_default(&config->mmu);
+}
+
+int gpu_system_config_parse_option(gpu_system_config_t* config, const char* option, const char* value) {
+    if (strcmp(option, "--l1-policy") == 0) {
+        if (replacement_policy_parse(value, &config->l1_policy) != 0) return -1;
+    } else if (strcmp(option, "--l2-policy") == 0) {
+        if (replacement_policy_parse(value, &config->l2_policy) != 0) return -1;
+    } else if (strcmp(option, "--l2-size") == 0) {
+        config->l2_size = (uint32_t)strtoul(value, NULL, 0) * 1024;
+    } else if (strcmp(option, "--l2-assoc") == 0) {
+        config->l2_associativity = (uint32_t)strtoul(value, NULL, 0);
+    } else if (strcmp(option, "--l2-set-sample") == 0) {
+        char* mode = NULL;
+        config->l2_sample_ratio = (uint32_t)strtoul(value, &mode, 0);
+        // Hashed by default: strided samples alias with strided access patterns
+        if (*mode == '\0' || strcmp(mode, ":hash") == 0) {
+            config->l2_set_sampling = SET_SAMPLING_HASHED;
+        } else if (strcmp(mode, ":strided") == 0) {
+            config->l2_set_sampling = SET_SAMPLING_STRIDED;
+        } else {
+            printf("Error: Unknown set sampling mode '%s' (use hash or strided)\n", mode + (*mode == ':'));
+            return -1;
+        }
+    } else if (strcmp(option, "--l2-slices") == 0) {
+        char* hash = NULL;
+        config->l2_slices = (uint32_t)strtoul(value, &hash, 0);
+        if (hash && *hash == ':' && slice_hash_parse(hash + 1, &config->l2_slice_hash) != 0) return -1;
+    } else if (strcmp(option, "--l1-prefetch") == 0) {
+        if (prefetcher_parse(value, &config->l1_prefetcher, &config->l1_prefetch_degree) != 0) return -1;
+    } else if (strcmp(option, "--l2-prefetch") == 0) {
+        if (prefetcher_parse(value, &config->l2_prefetcher, &config->l2_prefetch_degree) != 0) return -1;
+    } else if (strcmp(option, "--sector-size") == 0) {
+        config->sector_size = (uint32_t)strtoul(value, NULL, 0);
+    } else if (strcmp(option, "--inclusion") == 0) {
+        if (inclusion_policy_parse(value, &config->inclusion) != 0) return -1;
+    } else if (strcmp(option, "--l1-write") == 0) {
+        if (write_policy_parse(value, &config->l1_write_hit, &config->l1_write_miss) != 0) return -1;
+    } else if (strcmp(option, "--l2-write") == 0) {
+        if (write_policy_parse(value, &config->l2_write_hit, &config->l2_write_miss) != 0) return -1;
+    } else if (strcmp(option, "--l2-shadow") == 0) {
+        if (config->l2_shadows == CACHE_MAX_SHADOWS - 1) {
+            printf("Error: At most %u --l2-shadow configurations\n", CACHE_MAX_SHADOWS - 1);
+            return -1;
+        }
+        config->l2_shadow_ways[config->l2_shadows] = 0; // 0 = the L2's own associativity
+        if (shadow_spec_parse(value, &config->l2_shadow_policy[config->l2_shadows],
+                              &config->l2_shadow_ways[config->l2_shadows]) != 0) return -1;
+        config->l2_shadows++;
+    } else if (strcmp(option, "--l2-partition") == 0) {
+        if (partition_parse(value, &config->l2_partition_key, &config->l2_partitions,
+                            config->l2_partition_ways, &config->l2_partition_split) != 0) return -1;
+    } else if (strcmp(option, "--l2-ucp") == 0) {
+        config->l2_ucp_interval = (uint32_t)strtoul(value, NULL, 0);
+    } else if (strcmp(option, "--l1-victim") == 0) {
+        config->l1_victim_entries = (uint32_t)strtoul(value, NULL, 0);
+    } else if (strcmp(option, "--tlb") == 0) {
+        if (mmu_parse_page_size(value, &config->mmu.page_size) != 0) return -1;
+        config->mmu.enabled = true;
+    } else if (strcmp(option, "--tlb-region") == 0) {
+        if (mmu_parse_region(value, &config->mmu) != 0) return -1;
+    } else if (strcmp(option, "--tlb-l1") == 0) {
+        if (mmu_parse_tlb(value, &config->mmu.l1_tlb_entries, &config->mmu.l1_tlb_ways) != 0) return -1;
+    } else if (strcmp(option, "--tlb-l2") == 0) {
+        if (mmu_parse_tlb(value, &config->mmu.l2_tlb_entries, &config->mmu.l2_tlb_ways) != 0) return -1;
+    } else if (strcmp(option, "--tlb-pwc") == 0) {
+        config->mmu.pwc_entries = (uint32_t)strtoul(value, NULL, 0);
+    } else if (strcmp(option, "--tlb-walk") == 0) {
+        config->mmu.walk_latency = (uint32_t)strtoul(value, NULL, 0);
+    } else if (strcmp(option, "--dram-channels") == 0) {
+        config->dram.channels = (uint32_t)strtoul(value, NULL, 0);
+    } else if (strcmp(option, "--dram-banks") == 0) {
+        config->dram.banks = (uint32_t)strtoul(value, NULL, 0);
+    } else if (strcmp(option, "--dram-map") == 0) {
+        if (dram_parse_mapping(value, &config->dram.mapping) != 0) return -1;
+    } else {
+        return 1;
+    }
+    return 0;
+}
+
 gpu_memory_system_t* create_gpu_memory_system(void) {
+    gpu_system_config_t config;
+    gpu_system_config_default(&config);
+    return create_gpu_memory_system_with_config(&config);
+}
+
+gpu_memory_system_t* create_gpu_memory_system_with_config(const gpu_system_config_t* config) {
     gpu_memory_system_t* system = (gpu_memory_system_t*)malloc(sizeof(gpu_memory_system_t));
     if (!system) return NULL;
+    system->mmu = NULL;
+    system->last_translation = 0;
 
     // Initialize Registers
     for (int i = 0; i < MAX_THREADS; i++) {
@@ -14,19 +132,38 @@ gpu_memory_system_t* create_gpu_memory_system(void) {
     }
 
     // Create Cache Layers
-    system->shared_memory = cache_layer_create("Shared Memory (L1 Scratchpad)", SHARED_MEMORY_SIZE,
-        CACHE_LINE_SIZE, 1, REPLACEMENT_RANDOM, 20); // Direct Mapped/Random
-        
+    system->shared_memory = scratchpad_create("Shared Memory (Banked Scratchpad)", SHARED_MEMORY_SIZE,
+        SHARED_MEMORY_LATENCY);
+
     system->l1_cache = cache_layer_create("L1 Cache (Per-SM)", L1_CACHE_SIZE,
-        CACHE_LINE_SIZE, L1_ASSOCIATIVITY, REPLACEMENT_LRU, 30);
+        CACHE_LINE_SIZE, L1_ASSOCIATIVITY, config->l1_policy, 30);
 
-    system->l2_cache = cache_layer_create("L2 Cache (Global)", L2_CACHE_SIZE,
-        CACHE_LINE_SIZE, L2_ASSOCIATIVITY, REPLACEMENT_LRU, 200);
+    system->l2_cache = cache_layer_create_sampled("L2 Cache (Global)", config->l2_size,
+        CACHE_LINE_SIZE, config->l2_associativity, config->l2_policy, 200,
+        config->l2_set_sampling, config->l2_sample_ratio);
 
-    // Link the Hierarchy
-    // Shared Memory is not strictly part of the cache hierarchy, but for simulation, we link it as a layer before L2
-    system->shared_memory->next_level = system->l2_cache; 
+    if (!system->l1_cache || !system->l2_cache) {
+        system->dram = NULL;
+        system->global_memory = NULL;
+        free_gpu_memory_system(system);
+        return NULL;
+    }
+
+    // Link the Hierarchy (shared memory is a scratchpad outside it)
     system->l1_cache->next_level = system->l2_cache;
+    system->l2_cache->upper_level = system->l1_cache;
+    system->l2_cache->inclusion = config->inclusion;
+    system->l2_cache->memory_latency = GLOBAL_MEMORY_LATENCY;
+    system->l1_cache->write_hit = config->l1_write_hit;
+    system->l1_cache->write_miss = config->l1_write_miss;
+    system->l2_cache->write_hit = config->l2_write_hit;
+    system->l2_cache->write_miss = config->l2_write_miss;
+
+    // Prefetchers time their fills against the simulated clock
+    cache_layer_set_prefetcher(system->l1_cache, prefetcher_create(config->l1_prefetcher, config->l1_prefetch_degree));
+    cache_layer_set_prefetcher(system->l2_cache, prefetcher_create(config->l2_prefetcher, config->l2_prefetch_degree));
+    system->l1_cache->clock = &system->current_cycle;
+    system->l2_cache->clock = &system->current_cycle;
 
     // Initialize Global Memory
     system->global_memory_size = GLOBAL_MEMORY_SIZE;
@@ -34,7 +171,68 @@ gpu_memory_system_t* create_gpu_memory_system(void) {
 
     // Initialize Statistics
     system->total_accesses = system->register_hits = system->global_memory_accesses = 0;
+    system->total_latency = 0;
     system->current_cycle = 0;
+    system->l2_sampled_cycles = system->l2_sampled_misses = system->l2_estimated_accesses = 0;
+    system->last_level = MEM_LEVEL_REGISTER;
+
+    // DRAM behind the L2: demand misses, prefetch fills and writebacks are timed by it
+    system->defer_dram = false;
+    system->dram = dram_create(&config->dram);
+    if (!system->dram) {
+        free_gpu_memory_system(system);
+        return NULL;
+    }
+    system->l2_cache->memory = system->dram;
+
+    // Sectored L1/L2: 128B tags, fills and writebacks per sector
+    if (config->sector_size &&
+        (cache_layer_set_sectored(system->l1_cache, config->sector_size) != 0 ||
+         cache_layer_set_sectored(system->l2_cache, config->sector_size) != 0)) {
+        free_gpu_memory_system(system);
+        return NULL;
+    }
+
+    if (config->l2_slices > 1 &&
+        cache_layer_set_sliced(system->l2_cache, config->l2_slices, config->l2_slice_hash) != 0) {
+        free_gpu_memory_system(system);
+        return NULL;
+    }
+
+    if (config->mmu.enabled) {
+        system->mmu = mmu_create(&config->mmu);
+        if (!system->mmu) {
+            free_gpu_memory_system(system);
+            return NULL;
+        }
+    }
+
+    if (config->l1_victim_entries &&
+        cache_layer_set_victim_cache(system->l1_cache,
+            victim_cache_create(config->l1_victim_entries, VICTIM_CACHE_DEFAULT_LATENCY)) != 0) {
+        free_gpu_memory_system(system);
+        return NULL;
+    }
+
+    if (config->l2_partitions) {
+        partition_t* part = partition_create(config->l2_partition_key, config->l2_partitions,
+            config->l2_partition_split ? config->l2_partition_ways : NULL,
+            system->l2_cache->associativity, system->l2_cache->num_sets, config->l2_ucp_interval);
+        if (!part) {
+            free_gpu_memory_system(system);
+            return NULL;
+        }
+        cache_layer_set_partition(system->l2_cache, part);
+    }
+
+    // Shadow tags copy the final sectoring and write policy, so they come last
+    for (uint32_t i = 0; i < config->l2_shadows; i++) {
+        uint32_t ways = config->l2_shadow_ways[i] ? config->l2_shadow_ways[i] : config->l2_associativity;
+        if (cache_layer_add_shadow(system->l2_cache, config->l2_shadow_policy[i], ways) != 0) {
+            free_gpu_memory_system(system);
+            return NULL;
+        }
+    }
 
     return system;
 }
@@ -48,44 +246,97 @@ bool is_register_address(uint64_t address, uint32_t thread_id) {
 // Simplified check: is the address in the shared memory address space for this block?
 bool is_shared_memory_address(uint64_t address, uint32_t block_id) {
     // In a real GPU, shared memory addresses are virtual and small.
-    // For this simulation, we check if the address is very small and non-zero.
-    return address > 0 && address < SHARED_MEMORY_SIZE * MAX_BLOCKS; 
+    // For this simulation, we check if the address is very small and non-zero; the block's own
+    // scratchpad serves it at offset address % SHARED_MEMORY_SIZE.
+    (void)block_id;
+    return address > 0 && address < SHARED_MEMORY_SIZE * MAX_BLOCKS;
 }
 
+// Timed wrapper around the access path below, so every early return is covered
+static uint32_t gpu_memory_access_untimed(gpu_memory_system_t* system, memory_access_t* access);
+
 uint32_t gpu_memory_access(gpu_memory_system_t* system, memory_access_t* access) {
+    PROF_BEGIN(PROF_GPU_ACCESS);
+    uint32_t latency = gpu_memory_access_untimed(system, access);
+    if (system) system->total_latency += latency;
+    PROF_END(PROF_GPU_ACCESS);
+    return latency;
+}
+
+static uint32_t gpu_memory_access_untimed(gpu_memory_system_t* system, memory_access_t* access) {
     if (!system || !access) return 0;
 
     system->total_accesses++;
     uint32_t total_latency = 0;
 
     // 1. Check Registers
-    if (is_register_address(access->address, access->thread_id)) {
+    PROF_BEGIN(PROF_REGION_CHECK);
+    bool is_register = is_register_address(access->address, access->thread_id);
+    bool is_shared = !is_register && is_shared_memory_address(access->address, access->block_id);
+    PROF_END(PROF_REGION_CHECK);
+
+    if (is_register) {
         system->register_hits++;
+        system->last_level = MEM_LEVEL_REGISTER;
         return 1; // 1 cycle
     }
 
-    // 2. Check Shared Memory
-    if (is_shared_memory_address(access->address, access->block_id)) {
-        bool hit = cache_access(system->shared_memory, access);
-        total_latency += system->shared_memory->latency;
-        
-        // If it's a shared memory access, we treat the remaining hierarchy as separate.
-        // We only proceed to L1/L2 if it's NOT a dedicated shared memory access.
-        if (hit) return total_latency;
+    // 2. Shared Memory: always serviced by the block's scratchpad, bank conflicts add latency
+    if (is_shared) {
+        system->last_level = MEM_LEVEL_SHARED;
+        return scratchpad_access(system->shared_memory, access, (uint32_t)(access->address % SHARED_MEMORY_SIZE));
+    }
+
+    // 3. Translate: TLB misses and page walks delay the L1 lookup
+    system->last_translation = 0;
+    if (system->mmu) {
+        system->last_translation = mmu_translate(system->mmu, access);
+        total_latency += system->last_translation;
     }
 
-    // 3. Check L1 Cache
+    // 4. Check L1 Cache
     // Snapshot L2 stats so we can detect what happened during the L1 access (cache_access calls next level on miss).
     uint64_t l2_hits_before = system->l2_cache ? system->l2_cache->hits : 0;
     uint64_t l2_misses_before = system->l2_cache ? system->l2_cache->misses : 0;
+    uint64_t l2_sampled_out_before = system->l2_cache ? system->l2_cache->sampled_out : 0;
+    uint64_t victim_hits_before = system->l1_cache->victim ? system->l1_cache->victim->hits : 0;
+    uint64_t no_allocates_before = system->l1_cache->write_no_allocates;
 
     bool l1_hit = cache_access(system->l1_cache, access);
     total_latency += system->l1_cache->latency;
 
-    if (l1_hit) return total_latency;
+    // Stores forwarded below (write-through hits, no-allocate misses) are posted: the warp is
+    // done once the L1 has taken them, so they are reported as serviced by the L1
+    bool posted = !l1_hit && system->l1_cache->write_no_allocates > no_allocates_before;
+    if (l1_hit || posted) {
+        // An L1 miss caught by the victim cache pays its lookup on top
+        if (system->l1_cache->victim && system->l1_cache->victim->hits > victim_hits_before) {
+            total_latency += system->l1_cache->victim->latency;
+        }
+        // A posted store that missed the L2 still costs a DRAM fill, but nobody waits for it
+        if (system->l2_cache && system->l2_cache->misses > l2_misses_before) {
+            system->global_memory_accesses++;
+            if (!system->defer_dram) {
+                dram_read(system->dram, access->address, system->l2_cache->sector_size,
+                    system->current_cycle + total_latency);
+            }
+        }
+        system->last_level = MEM_LEVEL_L1;
+        return total_latency;
+    }
 
     // L1 miss: determine whether L2 was hit or missed by comparing deltas
-    if (system->l2_cache) {
+    uint32_t l1_latency = total_latency;
+    if (system->l2_cache && system->l2_cache->sampled_out > l2_sampled_out_before) {
+        // The L2 set is outside the sample: charge the mean cost below the L1 of the L1 misses
+        // that were simulated (an L2 miss until there is one)
+        total_latency += system->l2_sampled_misses
+            ? (uint32_t)(system->l2_sampled_cycles / system->l2_sampled_misses)
+            : system->l2_cache->latency + GLOBAL_MEMORY_LATENCY;
+        system->l2_estimated_accesses++;
+        system->last_level = MEM_LEVEL_L2;
+        return total_latency;
+    } else if (system->l2_cache) {
         uint64_t l2_hits_after = system->l2_cache->hits;
         uint64_t l2_misses_after = system->l2_cache->misses;
 
@@ -95,40 +346,119 @@ uint32_t gpu_memory_access(gpu_memory_system_t* system, memory_access_t* access)
         // If L2 was accessed and produced a hit
         if (l2_hits_delta > 0) {
             total_latency += system->l2_cache->latency;
+            system->last_level = MEM_LEVEL_L2;
         } else if (l2_misses_delta > 0) {
             // L2 miss -> went to global memory
             total_latency += system->l2_cache->latency;
             system->global_memory_accesses++;
-            total_latency += 400; // Global memory latency
+            if (system->defer_dram) {
+                total_latency += GLOBAL_MEMORY_LATENCY;
+            } else {
+                uint64_t now = system->current_cycle + total_latency;
+                total_latency += (uint32_t)(dram_read(system->dram, access->address,
+                    system->l2_cache->sector_size, now) - now);
+            }
+            system->last_level = MEM_LEVEL_GLOBAL;
         } else {
             // Fallback: if L2 stats didn't change, conservatively add L2 latency
             total_latency += system->l2_cache->latency;
+            system->last_level = MEM_LEVEL_L2;
         }
+        system->l2_sampled_cycles += total_latency - l1_latency;
+        system->l2_sampled_misses++;
     } else {
         // No L2 configured: go straight to global memory
         system->global_memory_accesses++;
-        total_latency += 400;
+        total_latency += GLOBAL_MEMORY_LATENCY;
+        system->last_level = MEM_LEVEL_GLOBAL;
     }
 
     // Return cumulative latency for this access
     return total_latency;
 }
 
+void gpu_memory_warm(gpu_memory_system_t* system, memory_access_t* access) {
+    if (!system || !access) return;
+
+    // Same routing as gpu_memory_access, but only tags and replacement state are updated.
+    // Registers and the scratchpad hold no state worth warming.
+    if (is_register_address(access->address, access->thread_id)) return;
+    if (is_shared_memory_address(access->address, access->block_id)) return;
+
+    if (system->mmu) mmu_warm(system->mmu, access);
+    cache_warm(system->l1_cache, access);
+}
+
+void gpu_memory_system_reset(gpu_memory_system_t* system) {
+    if (!system) return;
+    // Register files and global memory hold simulated data only, nothing the model reads back
+    scratchpad_reset(system->shared_memory);
+    cache_layer_reset(system->l1_cache);
+    cache_layer_reset(system->l2_cache);
+    mmu_reset(system->mmu);
+    dram_reset(system->dram);
+    system->defer_dram = false;
+    system->last_translation = 0;
+
+    system->total_accesses = system->register_hits = system->global_memory_accesses = 0;
+    system->total_latency = 0;
+    system->current_cycle = 0;
+    system->l2_sampled_cycles = system->l2_sampled_misses = system->l2_estimated_accesses = 0;
+    system->last_level = MEM_LEVEL_REGISTER;
+}
+
+void gpu_memory_system_bind_line_trace(gpu_memory_system_t* system, const line_trace_t* trace) {
+    if (!system) return;
+    const uint64_t* lines = trace ? trace->lines : NULL;
+    uint32_t num_lines = trace ? trace->num_lines : 0;
+    uint32_t line_size = trace ? trace->line_size : 0;
+    cache_layer_bind_lines(system->l1_cache, lines, num_lines, line_size);
+    cache_layer_bind_lines(system->l2_cache, lines, num_lines, line_size);
+}
+
 void print_gpu_system_stats(gpu_memory_system_t* system) {
     printf("\n\nGPU Cache & Memory Hierarchy Statistics\n");
     printf("=======================================\n");
     printf("Total Memory Accesses: %lu\n", system->total_accesses);
-    printf("Total Simulation Cycles: %u\n", system->current_cycle);
+    printf("Total Simulation Cycles: %lu%s\n", system->current_cycle,
+        system->l2_estimated_accesses ? " (estimated, see AMAT)" : "");
     printf("Register Hits: %lu\n", system->register_hits);
-    printf("Global Memory Accesses (L2 Misses): %lu\n\n", system->global_memory_accesses);
+    printf("Global Memory Accesses (L2 Misses): %lu\n", system->global_memory_accesses);
+    printf("Global Memory Traffic: %lu bytes read, %lu bytes written\n",
+        system->l2_cache->bytes_fetched, system->l2_cache->bytes_written_back);
+    if (system->l2_cache->set_sampling != SET_SAMPLING_NONE) {
+        printf("Estimated Global Memory Accesses (L2 set sampling): %.0f\n",
+            system->global_memory_accesses * get_sampling_scale(system->l2_cache));
+    }
 
-    print_cache_stats(system->shared_memory);
+    // Unique capacity: distinct lines held by L1 + L2; inclusive hierarchies spend L2 space on L1 copies
+    uint32_t l1_lines = cache_valid_lines(system->l1_cache);
+    uint32_t l2_lines = cache_valid_lines(system->l2_cache);
+    uint32_t duplicates = cache_duplicate_lines(system->l1_cache, system->l2_cache);
+    uint32_t unique_lines = l1_lines + l2_lines - duplicates;
+    printf("Inclusion: %s, Unique Capacity: %u of %u resident lines (%.1f KB of %.1f KB, %u lines duplicated, %.2f%% of L1)\n",
+        inclusion_policy_name(system->l2_cache->inclusion), unique_lines, l1_lines + l2_lines,
+        unique_lines * (double)CACHE_LINE_SIZE / 1024.0, (l1_lines + l2_lines) * (double)CACHE_LINE_SIZE / 1024.0,
+        duplicates, l1_lines ? (double)duplicates / l1_lines * 100.0 : 0.0);
+    printf("\n");
+
+    scratchpad_print_stats(system->shared_memory);
     print_cache_stats(system->l1_cache);
     print_cache_stats(system->l2_cache);
+    if (system->mmu) mmu_print_stats(system->mmu);
+    dram_print_stats(system->dram, system->current_cycle);
 
     if (system->total_accesses > 0) {
-        double avg_latency = (double)system->current_cycle / system->total_accesses;
-        printf("Average Memory Access Time: %.2f cycles\n", avg_latency);
+        double avg_latency = (double)system->total_latency / system->total_accesses;
+        if (system->l2_estimated_accesses) {
+            printf("Average Memory Access Time (estimated): %.2f cycles; %lu L1 misses outside the L2 set\n"
+                "  sample were charged the %.2f-cycle mean below the L1 of the %lu simulated ones\n", avg_latency,
+                system->l2_estimated_accesses, system->l2_sampled_misses
+                    ? (double)system->l2_sampled_cycles / system->l2_sampled_misses : 0.0,
+                system->l2_sampled_misses);
+        } else {
+            printf("Average Memory Access Time: %.2f cycles\n", avg_latency);
+        }
     }
 }
 
@@ -137,9 +467,11 @@ void free_gpu_memory_system(gpu_memory_system_t* system) {
 
     for (int i = 0; i < MAX_THREADS; i++) free(system->register_files[i]);
     
-    cache_layer_free(system->shared_memory);
+    scratchpad_free(system->shared_memory);
     cache_layer_free(system->l1_cache);
     cache_layer_free(system->l2_cache);
+    mmu_free(system->mmu);
+    dram_free(system->dram);
     
     if (system->global_memory) free(system->global_memory);
     free(system);
@@ -0,0 +1,236 @@
+#include "line_trace.h"
+#include "hash_table.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Both files start with magic, version, line size and line count; the record file adds the
+// record count and the records, the dictionary the line addresses, accesses and writes by ID
+#define LINE_TRACE_HEADER_WORDS 4
+
+static void line_trace_alloc_lines(line_trace_t* trace, uint32_t capacity) {
+    trace->lines = (uint64_t*)calloc((size_t)capacity + 1, sizeof(uint64_t));
+    trace->line_accesses = (uint32_t*)calloc((size_t)capacity + 1, sizeof(uint32_t));
+    trace->line_writes = (uint32_t*)calloc((size_t)capacity + 1, sizeof(uint32_t));
+}
+
+line_trace_t* line_trace_build(const memory_trace_t* traces, uint32_t count) {
+    line_trace_t* trace = (line_trace_t*)calloc(1, sizeof(line_trace_t));
+    if (!trace) return NULL;
+    trace->line_size = LINE_TRACE_LINE_SIZE;
+    trace->count = count;
+    trace->records = (line_trace_record_t*)malloc((size_t)count * sizeof(line_trace_record_t));
+    line_trace_alloc_lines(trace, count); // Every access may touch a new line
+    hash_table_t* ids = hash_table_create(count ? count : 1);
+    if (!trace->records || !trace->lines || !trace->line_accesses || !trace->line_writes || !ids) {
+        printf("Error: Failed to allocate memory for the line trace.\n");
+        hash_table_free(ids);
+        line_trace_free(trace);
+        return NULL;
+    }
+
+    for (uint32_t i = 0; i < count; i++) {
+        uint64_t line = traces[i].address / trace->line_size;
+        uint32_t id = hash_table_lookup(ids, line);
+        if (id == UINT32_MAX) {
+            id = ++trace->num_lines;
+            trace->lines[id] = line;
+            hash_table_insert(ids, line, id);
+        }
+        bool write = traces[i].operation == 'W';
+        trace->line_accesses[id]++;
+        if (write) trace->line_writes[id]++;
+
+        line_trace_record_t* rec = &trace->records[i];
+        rec->line_id = id;
+        rec->thread_id = (uint16_t)(traces[i].thread_id % MAX_THREADS);
+        rec->block_id = (uint8_t)(traces[i].block_id % MAX_BLOCKS);
+        rec->offset = (uint8_t)(traces[i].address % trace->line_size) | (write ? LINE_TRACE_WRITE : 0);
+        rec->stream_id = traces[i].stream_id;
+    }
+    hash_table_free(ids);
+
+    // The dictionary was sized for one line per access
+    size_t n = (size_t)trace->num_lines + 1;
+    uint64_t* lines = (uint64_t*)realloc(trace->lines, n * sizeof(uint64_t));
+    uint32_t* accesses = (uint32_t*)realloc(trace->line_accesses, n * sizeof(uint32_t));
+    uint32_t* writes = (uint32_t*)realloc(trace->line_writes, n * sizeof(uint32_t));
+    if (lines) trace->lines = lines;
+    if (accesses) trace->line_accesses = accesses;
+    if (writes) trace->line_writes = writes;
+    return trace;
+}
+
+static void write_bytes(FILE* file, const void* data, size_t len, bool* ok) {
+    if (*ok && fwrite(data, 1, len, file) != len) *ok = false;
+}
+
+static void read_bytes(FILE* file, void* data, size_t len, bool* ok) {
+    if (*ok && fread(data, 1, len, file) != len) *ok = false;
+}
+
+static void write_header(FILE* file, const line_trace_t* trace, bool* ok) {
+    uint32_t header[LINE_TRACE_HEADER_WORDS] = { LINE_TRACE_MAGIC, LINE_TRACE_VERSION, trace->line_size, trace->num_lines };
+    write_bytes(file, header, sizeof(header), ok);
+}
+
+// Reads a header and checks it against what the trace already holds (line_size 0 = first file)
+static bool read_header(FILE* file, line_trace_t* trace) {
+    uint32_t header[LINE_TRACE_HEADER_WORDS];
+    bool ok = true;
+    read_bytes(file, header, sizeof(header), &ok);
+    if (!ok || header[0] != LINE_TRACE_MAGIC || header[1] != LINE_TRACE_VERSION) return false;
+    if (trace->line_size) return header[2] == trace->line_size && header[3] == trace->num_lines;
+    trace->line_size = header[2];
+    trace->num_lines = header[3];
+    return trace->line_size && trace->line_size <= LINE_TRACE_OFFSET_MASK + 1;
+}
+
+static char* line_trace_dict_path(const char* path) {
+    char* dict = (char*)malloc(strlen(path) + sizeof(LINE_TRACE_DICT_SUFFIX));
+    if (dict) sprintf(dict, "%s" LINE_TRACE_DICT_SUFFIX, path);
+    return dict;
+}
+
+int line_trace_save(const line_trace_t* trace, const char* path) {
+    char* dict_path = line_trace_dict_path(path);
+    FILE* file = fopen(path, "wb");
+    FILE* dict = dict_path ? fopen(dict_path, "wb") : NULL;
+    if (!file || !dict) {
+        printf("Error: Cannot open %s for writing\n", !file ? path : dict_path ? dict_path : path);
+        if (file) fclose(file);
+        if (dict) fclose(dict);
+        free(dict_path);
+        return -1;
+    }
+
+    bool ok = true;
+    write_header(file, trace, &ok);
+    write_bytes(file, &trace->count, sizeof(trace->count), &ok);
+    write_bytes(file, trace->records, (size_t)trace->count * sizeof(line_trace_record_t), &ok);
+    write_header(dict, trace, &ok);
+    write_bytes(dict, trace->lines + 1, (size_t)trace->num_lines * sizeof(uint64_t), &ok);
+    write_bytes(dict, trace->line_accesses + 1, (size_t)trace->num_lines * sizeof(uint32_t), &ok);
+    write_bytes(dict, trace->line_writes + 1, (size_t)trace->num_lines * sizeof(uint32_t), &ok);
+    ok &= fclose(file) == 0;
+    ok &= fclose(dict) == 0;
+
+    if (!ok) printf("Error: Failed to write line trace %s\n", path);
+    free(dict_path);
+    return ok ? 0 : -1;
+}
+
+bool line_trace_is_file(const char* path) {
+    FILE* file = fopen(path, "rb");
+    if (!file) return false;
+    uint32_t magic = 0;
+    bool ok = fread(&magic, sizeof(magic), 1, file) == 1;
+    fclose(file);
+    return ok && magic == LINE_TRACE_MAGIC;
+}
+
+line_trace_t* line_trace_load(const char* path) {
+    line_trace_t* trace = (line_trace_t*)calloc(1, sizeof(line_trace_t));
+    char* dict_path = line_trace_dict_path(path);
+    FILE* file = fopen(path, "rb");
+    FILE* dict = dict_path ? fopen(dict_path, "rb") : NULL;
+    bool ok = trace && file && dict;
+    if (!ok) {
+        printf("Error: Cannot open line trace %s (and its dictionary %s)\n", path, dict_path ? dict_path : "");
+    } else if (!read_header(file, trace) || !read_header(dict, trace)) {
+        printf("Error: %s is not a version %d line trace with a matching dictionary\n", path, LINE_TRACE_VERSION);
+        ok = false;
+    }
+
+    if (ok) {
+        read_bytes(file, &trace->count, sizeof(trace->count), &ok);
+        trace->records = ok ? (line_trace_record_t*)malloc((size_t)trace->count * sizeof(line_trace_record_t) + 1) : NULL;
+        line_trace_alloc_lines(trace, trace->num_lines);
+        ok = ok && trace->records && trace->lines && trace->line_accesses && trace->line_writes;
+        read_bytes(file, trace->records, (size_t)trace->count * sizeof(line_trace_record_t), &ok);
+        read_bytes(dict, trace->lines + 1, (size_t)trace->num_lines * sizeof(uint64_t), &ok);
+        read_bytes(dict, trace->line_accesses + 1, (size_t)trace->num_lines * sizeof(uint32_t), &ok);
+        read_bytes(dict, trace->line_writes + 1, (size_t)trace->num_lines * sizeof(uint32_t), &ok);
+        // IDs index the dictionary directly in the simulation loop
+        for (uint32_t i = 0; ok && i < trace->count; i++) {
+            ok = trace->records[i].line_id >= 1 && trace->records[i].line_id <= trace->num_lines;
+        }
+        if (!ok) printf("Error: Line trace %s is truncated or corrupt\n", path);
+    }
+
+    if (file) fclose(file);
+    if (dict) fclose(dict);
+    free(dict_path);
+    if (!ok) {
+        line_trace_free(trace);
+        return NULL;
+    }
+    return trace;
+}
+
+memory_trace_t* line_trace_expand(const line_trace_t* trace) {
+    memory_trace_t* traces = (memory_trace_t*)malloc((size_t)trace->count * sizeof(memory_trace_t) + 1);
+    if (!traces) {
+        printf("Error: Failed to allocate memory for traces.\n");
+        return NULL;
+    }
+    for (uint32_t i = 0; i < trace->count; i++) {
+        memory_access_t access;
+        line_trace_access(trace, i, &access);
+        traces[i] = (memory_trace_t){
+            .operation = access.type == ACCESS_WRITE ? 'W' : 'R',
+            .address = access.address,
+            .size = 0,
+            .thread_id = access.thread_id,
+            .block_id = access.block_id,
+            .stream_id = access.stream_id
+        };
+    }
+    return traces;
+}
+
+void line_trace_print_summary(const line_trace_t* trace) {
+    if (!trace || trace->count == 0) return;
+
+    uint32_t writes = 0;
+    uint64_t min_addr = UINT64_MAX, max_addr = 0;
+    for (uint32_t i = 0; i < trace->count; i++) {
+        const line_trace_record_t* rec = &trace->records[i];
+        uint64_t address = trace->lines[rec->line_id] * trace->line_size + (rec->offset & LINE_TRACE_OFFSET_MASK);
+        if (rec->offset & LINE_TRACE_WRITE) writes++;
+        if (address < min_addr) min_addr = address;
+        if (address > max_addr) max_addr = address;
+    }
+    uint32_t reads = trace->count - writes;
+
+    printf("Memory Trace Summary:\n");
+    printf("  Total Accesses: %u\n", trace->count);
+    printf("  Reads: %u (%.1f%%)\n", reads, (double)reads / trace->count * 100.0);
+    printf("  Writes: %u (%.1f%%)\n", writes, (double)writes / trace->count * 100.0);
+    printf("  Address Range: 0x%lx - 0x%lx\n\n", min_addr, max_addr);
+
+    uint32_t written = 0, single = 0, hottest = 1;
+    for (uint32_t id = 1; id <= trace->num_lines; id++) {
+        if (trace->line_writes[id]) written++;
+        if (trace->line_accesses[id] == 1) single++;
+        if (trace->line_accesses[id] > trace->line_accesses[hottest]) hottest = id;
+    }
+    printf("Trace Footprint (%u-byte lines):\n", trace->line_size);
+    printf("  Distinct Lines: %u (%lu KB)\n", trace->num_lines, (uint64_t)trace->num_lines * trace->line_size / 1024);
+    printf("  Written Lines: %u (%.1f%%)\n", written, (double)written / trace->num_lines * 100.0);
+    printf("  Single-Access Lines: %u (%.1f%%)\n", single, (double)single / trace->num_lines * 100.0);
+    printf("  Accesses per Line: %.2f (hottest: 0x%lx, %u accesses)\n", (double)trace->count / trace->num_lines,
+        trace->lines[hottest] * trace->line_size, trace->line_accesses[hottest]);
+    printf("  Trace Memory: %lu KB (%lu KB as text-trace records)\n\n",
+        ((uint64_t)trace->count * sizeof(line_trace_record_t) + (uint64_t)trace->num_lines * (sizeof(uint64_t) + 2 * sizeof(uint32_t))) / 1024,
+        (uint64_t)trace->count * sizeof(memory_trace_t) / 1024);
+}
+
+void line_trace_free(line_trace_t* trace) {
+    if (!trace) return;
+    free(trace->records);
+    free(trace->lines);
+    free(trace->line_accesses);
+    free(trace->line_writes);
+    free(trace);
+}
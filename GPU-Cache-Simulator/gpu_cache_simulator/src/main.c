@@ -1,16 +1,251 @@
+#define _POSIX_C_SOURCE 200809L
 #include "gpu_memory_system.h"
 #include "utils.h"
+#include "profiler.h"
+#include "checkpoint.h"
+#include "sampling.h"
+#include "miss_stream.h"
+#include "timing_engine.h"
+#include "server.h"
+#include "line_trace.h"
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <time.h>
 
+// --- Command Line Options ---
+typedef struct {
+    const char* trace_file;
+    const char* checkpoint_path;  // Checkpoint written periodically and at the end of the run
+    uint64_t checkpoint_every;    // 0 = only at the end
+    const char* restore_path;     // Resume from this checkpoint
+    uint64_t stop_at;             // Stop (and checkpoint) once this trace offset is reached; 0 = run to the end
+    bool sampling;
+    sampling_config_t sampling_config;
+    gpu_system_config_t system_config;
+    const char* capture_misses_path; // Record the request stream entering the L2
+    const char* replay_misses_path;  // Replay a recorded stream into the L2 only (no trace file)
+    uint32_t replay_threads;         // > 1: replay the slices of a sliced L2 in parallel
+    bool event_timing;               // Event-driven engine instead of serialized latencies
+    const char* serve_path;          // Run as a daemon on this Unix socket (no trace file)
+    uint32_t serve_workers;
+    const char* make_line_trace_path; // Write the trace as a line-ID trace and exit
+    timing_config_t timing_config;
+} sim_options_t;
+
 void print_usage(const char* prog) {
-    printf("Usage: %s <trace_file>\n", prog);
+    printf("Usage: %s [options] <trace_file>\n", prog);
+    printf("       %s --make-line-trace <out> <trace_file>\n", prog);
+    printf("       %s [L2 options] --replay-misses <file>\n", prog);
+    printf("       %s [hierarchy options] --serve <socket>\n", prog);
+    printf("\nOptions:\n");
+    printf("  --checkpoint <file>       Save hierarchy state to <file> at the end of the run\n");
+    printf("  --checkpoint-every <n>    Also save every <n> accesses\n");
+    printf("  --restore <file>          Resume from a checkpoint written for the same trace\n");
+    printf("  --stop-at <n>             Stop after trace entry <n> (e.g. to save a warmed-up state)\n");
+    printf("  --sample <ff:wu:m[:skip]> Sampled simulation: per period fast-forward ff accesses\n");
+    printf("                            (functional warming, or dropped with :skip), warm up wu,\n");
+    printf("                            then measure m; prints estimates with confidence intervals\n");
+    printf("                            (not with checkpoints)\n");
+    printf("  --l1-policy <name>        L1 replacement: lru (default), fifo, lfu, random, srrip, brrip,\n");
+    printf("                            drrip or ship\n");
+    printf("  --l2-policy <name>        L2 replacement, as above\n");
+    printf("  --l2-size <kb>            L2 capacity in KB (default %u)\n", L2_CACHE_SIZE / 1024);
+    printf("  --l2-assoc <n>            L2 associativity (default %u)\n", L2_ASSOCIATIVITY);
+    printf("  --l2-set-sample <n>[:m]   Simulate 1 in n L2 sets, picked by hash (default) or strided,\n");
+    printf("                            and scale counts to every access the L2 saw\n");
+    printf("  --l2-slices <n>[:hash]    Split the L2 into n slices chosen by a linear, xor (default) or\n");
+    printf("                            mix hash of the line address; reports per-slice load\n");
+    printf("  --l1-prefetch <type>[:d] L1 prefetcher: none, next-line, stride or stream, degree d (default %u)\n",
+        PREFETCH_DEFAULT_DEGREE);
+    printf("  --l2-prefetch <type>[:d] L2 prefetcher, as above\n");
+    printf("  --sector-size <bytes>     Sectored L1/L2: tags per line, fills per sector (e.g. 32)\n");
+    printf("  --inclusion <mode>        L2 vs L1 contents: nine (default), inclusive or exclusive\n");
+    printf("  --l1-write <hit[:miss]>   L1 write policy: back|through[:allocate|:no-allocate]\n");
+    printf("                            (default through:no-allocate)\n");
+    printf("  --l2-write <hit[:miss]>   L2 write policy, as above (default back:allocate)\n");
+    printf("  --l2-shadow <name>[:ways] Estimate the L2 hit rate under another replacement policy and\n");
+    printf("                            way count from shadow tags on 1/%u of its sets (up to %u)\n",
+        SHADOW_SAMPLE_RATIO, CACHE_MAX_SHADOWS - 1);
+    printf("  --l2-partition <key>:<n>[:w0,w1,...] Way-partition the L2 among n partitions keyed by\n");
+    printf("                            block or stream (6th trace column), equal split by default\n");
+    printf("  --l2-ucp <interval>       Utility-based repartitioning every <interval> L2 accesses\n");
+    printf("                            (e.g. %u)\n", UCP_DEFAULT_INTERVAL);
+    printf("  --l1-victim <entries>     Fully associative victim cache between L1 and L2\n");
+    printf("  --tlb <4K|64K|2M>         Translate addresses through per-SM L1 TLBs, a shared L2 TLB and\n");
+    printf("                            page walks, with the given default page size\n");
+    printf("  --tlb-region <page>:<start>:<end> Use another page size in [start, end) (up to %u)\n", MMU_MAX_REGIONS);
+    printf("  --tlb-l1 <entries>[:ways] Per-SM L1 TLB (default %u, fully associative)\n", MMU_DEFAULT_L1_TLB_ENTRIES);
+    printf("  --tlb-l2 <entries>[:ways] Shared L2 TLB (default %u:%u)\n", MMU_DEFAULT_L2_TLB_ENTRIES,
+        MMU_DEFAULT_L2_TLB_WAYS);
+    printf("  --tlb-pwc <entries>       Page-walk cache entries, 0 = none (default %u)\n", MMU_DEFAULT_PWC_ENTRIES);
+    printf("  --tlb-walk <cycles>       Cycles per page-table level read (default %u)\n", MMU_DEFAULT_WALK_LATENCY);
+    printf("  --dram-channels <n>       DRAM channels behind the L2 (default %u)\n", DRAM_DEFAULT_CHANNELS);
+    printf("  --dram-banks <n>          Banks per DRAM channel (default %u)\n", DRAM_DEFAULT_BANKS);
+    printf("  --dram-map <line|row|xor> DRAM address interleaving (default line)\n");
+    printf("  --capture-misses <file>   Record misses and writebacks sent to the L2 (binary)\n");
+    printf("  --replay-misses <file>    Feed a recorded stream straight into the L2 (L2 sweeps)\n");
+    printf("  --replay-threads <n>      Replay the slices of a sliced L2 on up to <n> threads\n");
+    printf("  --serve <socket>          Run as a daemon taking jobs on a Unix domain socket; the\n");
+    printf("                            hierarchy options given here are the jobs' defaults\n");
+    printf("  --serve-workers <n>       Jobs simulated concurrently (default %u)\n", SERVER_DEFAULT_WORKERS);
+    printf("  --make-line-trace <out>   Preprocess a text trace into dense line IDs (<out>, plus the\n");
+    printf("                            dictionary <out>%s) and exit; <out> is then accepted as\n", LINE_TRACE_DICT_SUFFIX);
+    printf("                            <trace_file> and simulates faster\n");
+    printf("  --timing <serial|event>   Serialized latencies (default) or the event-driven engine\n");
+    printf("  --l1-mshrs <n>            Event timing: L1 MSHR entries (default %u)\n", TIMING_DEFAULT_L1_MSHRS);
+    printf("  --l2-mshrs <n>            Event timing: L2 MSHR entries (default %u)\n", TIMING_DEFAULT_L2_MSHRS);
+    printf("  --l1-bw <bytes>           Event timing: L2->L1 bytes/cycle, 0 = unlimited (default %u)\n", TIMING_DEFAULT_L1_BANDWIDTH);
+    printf("  --l2-bw <bytes>           Event timing: DRAM->L2 bytes/cycle, 0 = unlimited (default %u)\n", TIMING_DEFAULT_L2_BANDWIDTH);
+    printf("  --issue-width <n>         Event timing: accesses issued per cycle (default %u)\n", TIMING_DEFAULT_ISSUE_WIDTH);
+    printf("  --warp-size <n>           Event timing: threads per warp (default %u)\n", TIMING_DEFAULT_WARP_SIZE);
     printf("\nExample: %s data/memory_trace.txt\n", prog);
 }
 
+static int parse_options(int argc, char* argv[], sim_options_t* opts) {
+    memset(opts, 0, sizeof(*opts));
+    opts->serve_workers = SERVER_DEFAULT_WORKERS;
+    gpu_system_config_default(&opts->system_config);
+    timing_config_default(&opts->timing_config);
+
+    for (int i = 1; i < argc; i++) {
+        const char* arg = argv[i];
+        bool has_value = i + 1 < argc;
+
+        // Hierarchy options are shared with the job descriptions of --serve
+        int parsed = has_value ? gpu_system_config_parse_option(&opts->system_config, arg, argv[i + 1]) : 1;
+        if (parsed < 0) return -1;
+        if (parsed == 0) {
+            i++;
+            continue;
+        }
+
+        if (strcmp(arg, "--checkpoint") == 0 && has_value) {
+            opts->checkpoint_path = argv[++i];
+        } else if (strcmp(arg, "--checkpoint-every") == 0 && has_value) {
+            opts->checkpoint_every = strtoull(argv[++i], NULL, 0);
+        } else if (strcmp(arg, "--restore") == 0 && has_value) {
+            opts->restore_path = argv[++i];
+        } else if (strcmp(arg, "--stop-at") == 0 && has_value) {
+            opts->stop_at = strtoull(argv[++i], NULL, 0);
+        } else if (strcmp(arg, "--sample") == 0 && has_value) {
+            if (sampling_parse(argv[++i], &opts->sampling_config) != 0) return -1;
+            opts->sampling = true;
+        } else if (strcmp(arg, "--capture-misses") == 0 && has_value) {
+            opts->capture_misses_path = argv[++i];
+        } else if (strcmp(arg, "--replay-misses") == 0 && has_value) {
+            opts->replay_misses_path = argv[++i];
+        } else if (strcmp(arg, "--replay-threads") == 0 && has_value) {
+            opts->replay_threads = (uint32_t)strtoul(argv[++i], NULL, 0);
+        } else if (strcmp(arg, "--serve") == 0 && has_value) {
+            opts->serve_path = argv[++i];
+        } else if (strcmp(arg, "--serve-workers") == 0 && has_value) {
+            opts->serve_workers = (uint32_t)strtoul(argv[++i], NULL, 0);
+        } else if (strcmp(arg, "--make-line-trace") == 0 && has_value) {
+            opts->make_line_trace_path = argv[++i];
+        } else if (strcmp(arg, "--timing") == 0 && has_value) {
+            const char* mode = argv[++i];
+            if (strcmp(mode, "event") == 0) opts->event_timing = true;
+            else if (strcmp(mode, "serial") != 0) return -1;
+        } else if (strcmp(arg, "--l1-mshrs") == 0 && has_value) {
+            opts->timing_config.l1_mshrs = (uint32_t)strtoul(argv[++i], NULL, 0);
+        } else if (strcmp(arg, "--l2-mshrs") == 0 && has_value) {
+            opts->timing_config.l2_mshrs = (uint32_t)strtoul(argv[++i], NULL, 0);
+        } else if (strcmp(arg, "--l1-bw") == 0 && has_value) {
+            opts->timing_config.l1_bandwidth = (uint32_t)strtoul(argv[++i], NULL, 0);
+        } else if (strcmp(arg, "--l2-bw") == 0 && has_value) {
+            opts->timing_config.l2_bandwidth = (uint32_t)strtoul(argv[++i], NULL, 0);
+        } else if (strcmp(arg, "--issue-width") == 0 && has_value) {
+            opts->timing_config.issue_width = (uint32_t)strtoul(argv[++i], NULL, 0);
+        } else if (strcmp(arg, "--warp-size") == 0 && has_value) {
+            opts->timing_config.warp_size = (uint32_t)strtoul(argv[++i], NULL, 0);
+        } else if (arg[0] != '-' && !opts->trace_file) {
+            opts->trace_file = arg;
+        } else {
+            return -1;
+        }
+    }
+
+    if (opts->system_config.l2_size == 0 || opts->system_config.l2_associativity == 0) return -1;
+    if (opts->event_timing && (opts->sampling || opts->checkpoint_every > 0)) {
+        printf("Error: --timing event cannot be combined with --sample or --checkpoint-every\n");
+        return -1;
+    }
+    if (opts->sampling && (opts->checkpoint_path || opts->restore_path)) {
+        // Sampler periods and running statistics are not part of a checkpoint
+        printf("Error: --sample cannot be combined with --checkpoint, --checkpoint-every or --restore\n");
+        return -1;
+    }
+    if (opts->make_line_trace_path && !opts->trace_file) return -1;
+    return (opts->trace_file || opts->replay_misses_path || opts->serve_path) ? 0 : -1;
+}
+
+// L2-only run driven by a stream captured with --capture-misses
+static int run_miss_replay(const sim_options_t* opts) {
+    gpu_memory_system_t* system = create_gpu_memory_system_with_config(&opts->system_config);
+    if (!system) {
+        printf("Error: Failed to create GPU memory system.\n");
+        return 1;
+    }
+
+    // A replay has no notion of time, so L2 prefetches are never counted as late and the DRAM
+    // is not consulted
+    system->l2_cache->clock = NULL;
+    system->l2_cache->memory = NULL;
+    system->l2_cache->upper_level = NULL; // No L1 to back-invalidate or hand lines to
+
+    printf("Replaying miss stream %s into the L2...\n", opts->replay_misses_path);
+
+    // Wall-clock time: clock() would add up the CPU time of every replay thread
+    miss_replay_stats_t stats;
+    struct timespec start_time, end_time;
+    clock_gettime(CLOCK_MONOTONIC, &start_time);
+    int result = opts->replay_threads > 1
+        ? miss_stream_replay_parallel(opts->replay_misses_path, system->l2_cache, opts->replay_threads, &stats)
+        : miss_stream_replay(opts->replay_misses_path, system->l2_cache, &stats);
+    clock_gettime(CLOCK_MONOTONIC, &end_time);
+    double elapsed = (double)(end_time.tv_sec - start_time.tv_sec) + (end_time.tv_nsec - start_time.tv_nsec) / 1e9;
+
+    if (result == 0) {
+        printf("Replay completed in %.2f seconds\n", elapsed);
+        printf("Records: %lu (%lu demand, %lu writebacks)\n\n", stats.records, stats.demand, stats.writebacks);
+        print_cache_stats(system->l2_cache);
+        printf("Global Memory Accesses (L2 Misses): %lu\n", system->l2_cache->misses);
+        printf("\nSimulation Performance:\n");
+        printf(" Replay Speed: %.2f records/second\n\n", stats.records / elapsed);
+    }
+
+    free_gpu_memory_system(system);
+    return result == 0 ? 0 : 1;
+}
+
+// --make-line-trace: parse the text trace once and keep it as line IDs for later runs
+static int run_make_line_trace(const sim_options_t* opts) {
+    if (line_trace_is_file(opts->trace_file)) {
+        printf("Error: %s is already a line trace\n", opts->trace_file);
+        return 1;
+    }
+    memory_trace_t* traces = NULL;
+    uint32_t trace_count = 0;
+    if (load_memory_trace(opts->trace_file, &traces, &trace_count) != 0) return 1;
+
+    line_trace_t* trace = line_trace_build(traces, trace_count);
+    free_memory_trace(traces);
+    if (!trace) return 1;
+
+    int result = line_trace_save(trace, opts->make_line_trace_path);
+    if (result == 0) {
+        printf("Wrote line trace %s and %s%s (%u accesses, %u lines)\n\n", opts->make_line_trace_path,
+            opts->make_line_trace_path, LINE_TRACE_DICT_SUFFIX, trace->count, trace->num_lines);
+        line_trace_print_summary(trace);
+    }
+    line_trace_free(trace);
+    return result == 0 ? 0 : 1;
+}
+
 int main(int argc, char* argv[]) {
-    if (argc != 2) {
+    sim_options_t opts;
+    if (parse_options(argc, argv, &opts) != 0) {
         print_usage(argv[0]);
         return 1;
     }
@@ -18,57 +253,153 @@ int main(int argc, char* argv[]) {
     printf("GPU Cache & Memory Hierarchy Simulator\n");
     printf("======================================\n\n");
 
+    if (opts.replay_misses_path) return run_miss_replay(&opts);
+    if (opts.serve_path) {
+        server_config_t server_config = { opts.serve_path, opts.serve_workers, opts.system_config };
+        return server_run(&server_config) == 0 ? 0 : 1;
+    }
+
+    if (opts.make_line_trace_path) return run_make_line_trace(&opts);
+
     memory_trace_t* traces = NULL;
+    line_trace_t* line_trace = NULL;
     uint32_t trace_count = 0;
 
-    if (load_memory_trace(argv[1], &traces, &trace_count) != 0) return 1;
+    if (line_trace_is_file(opts.trace_file)) {
+        line_trace = line_trace_load(opts.trace_file);
+        if (!line_trace) return 1;
+        trace_count = line_trace->count;
+        // The event-driven engine works on full records
+        if (opts.event_timing && !(traces = line_trace_expand(line_trace))) {
+            line_trace_free(line_trace);
+            return 1;
+        }
+    } else if (load_memory_trace(opts.trace_file, &traces, &trace_count) != 0) {
+        return 1;
+    }
 
-    printf("Loaded %u memory accesses from %s\n", trace_count, argv[1]);
-    print_trace_summary(traces, trace_count);
+    printf("Loaded %u memory accesses from %s\n", trace_count, opts.trace_file);
+    if (line_trace) line_trace_print_summary(line_trace);
+    else print_trace_summary(traces, trace_count);
 
-    gpu_memory_system_t* system = create_gpu_memory_system();
+    gpu_memory_system_t* system = create_gpu_memory_system_with_config(&opts.system_config);
     if (!system) {
         printf("Error: Failed to create GPU memory system.\n");
         free_memory_trace(traces);
+        line_trace_free(line_trace);
         return 1;
     }
 
+    if (line_trace) gpu_memory_system_bind_line_trace(system, line_trace);
+
+    uint64_t start_offset = 0;
+    if (opts.restore_path) {
+        if (checkpoint_restore(opts.restore_path, system, &start_offset) != 0) {
+            free_memory_trace(traces);
+            line_trace_free(line_trace);
+            free_gpu_memory_system(system);
+            return 1;
+        }
+        if (start_offset > trace_count) start_offset = trace_count;
+        printf("Restored checkpoint %s at trace offset %lu\n", opts.restore_path, start_offset);
+    }
+
+    uint32_t end_offset = trace_count;
+    if (opts.stop_at > 0 && opts.stop_at < trace_count) end_offset = (uint32_t)opts.stop_at;
+
+    // The L1 is the only layer feeding the L2 (shared memory is a scratchpad)
+    miss_stream_t* capture = NULL;
+    if (opts.capture_misses_path) {
+        capture = miss_stream_open(opts.capture_misses_path);
+        if (!capture) {
+            free_memory_trace(traces);
+            line_trace_free(line_trace);
+            free_gpu_memory_system(system);
+            return 1;
+        }
+        system->l1_cache->miss_stream = capture;
+    }
+
+    sampler_t sampler;
+    if (opts.sampling) sampler_init(&sampler, &opts.sampling_config);
+
     printf("Running simulation...\n");
 
     clock_t start_time = clock();
 
-    for (uint32_t i = 0; i < trace_count; i++) {
-        memory_trace_t* trace = &traces[i];
-        
-        memory_access_t access = {
-            .address = trace->address,
-            .type = (trace->operation == 'W') ? ACCESS_WRITE : ACCESS_READ,
-            // Ensure thread/block IDs are within bounds
-            .thread_id = trace->thread_id % MAX_THREADS, 
-            .block_id = trace->block_id % MAX_BLOCKS 
-        };
-
-        // Note: Latency calculation is simplified in gpu_memory_access
-        uint32_t latency = gpu_memory_access(system, &access);
-        system->current_cycle += latency;
-        
-        if ((i + 1) % 100 == 0) {
-            printf(" Processed: %u/%u accesses\r", i + 1, trace_count);
-            fflush(stdout);
+    timing_stats_t timing_stats;
+    bool timing_ok = false;
+
+    if (opts.event_timing) {
+        timing_ok = timing_run(system, traces, (uint32_t)start_offset, end_offset,
+            &opts.timing_config, &timing_stats) == 0;
+    } else {
+        for (uint32_t i = (uint32_t)start_offset; i < end_offset; i++) {
+            memory_access_t access;
+            if (line_trace) {
+                line_trace_access(line_trace, i, &access);
+            } else {
+                memory_trace_t* trace = &traces[i];
+                access = (memory_access_t){
+                    .address = trace->address,
+                    .type = (trace->operation == 'W') ? ACCESS_WRITE : ACCESS_READ,
+                    // Ensure thread/block IDs are within bounds
+                    .thread_id = trace->thread_id % MAX_THREADS,
+                    .block_id = trace->block_id % MAX_BLOCKS,
+                    .stream_id = trace->stream_id
+                };
+            }
+
+            if (opts.sampling && sampler_next_phase(&sampler, system) == SAMPLE_PHASE_FAST_FORWARD) {
+                if (!opts.sampling_config.skip) gpu_memory_warm(system, &access);
+            } else {
+                // Note: Latency calculation is simplified in gpu_memory_access
+                uint32_t latency = gpu_memory_access(system, &access);
+                system->current_cycle += latency;
+            }
+
+            if ((i + 1) % 100 == 0) {
+                printf(" Processed: %u/%u accesses\r", i + 1, trace_count);
+                fflush(stdout);
+            }
+
+            if (opts.checkpoint_path && opts.checkpoint_every > 0 && (i + 1) % opts.checkpoint_every == 0) {
+                checkpoint_save(opts.checkpoint_path, system, i + 1);
+            }
         }
     }
 
     clock_t end_time = clock();
     double elapsed = (double)(end_time - start_time) / CLOCKS_PER_SEC;
 
+    if (opts.sampling) sampler_finish(&sampler, system);
+
     printf("\nSimulation completed in %.2f seconds\n", elapsed);
 
+    if (opts.checkpoint_path && checkpoint_save(opts.checkpoint_path, system, end_offset) == 0) {
+        printf("Checkpoint saved to %s at trace offset %u\n", opts.checkpoint_path, end_offset);
+    }
+
+    if (capture) {
+        printf("Captured %lu L2 requests (%lu writebacks) to %s\n",
+            capture->records, capture->writebacks, opts.capture_misses_path);
+        miss_stream_close(capture);
+    }
+
     print_gpu_system_stats(system);
+    if (opts.sampling) sampler_print_report(&sampler, end_offset - start_offset);
+    if (timing_ok) {
+        timing_print_stats(&timing_stats, &opts.timing_config);
+        timing_stats_free(&timing_stats);
+    }
 
     printf("\nSimulation Performance:\n");
-    printf(" Simulation Speed: %.2f accesses/second\n\n", trace_count / elapsed);
+    printf(" Simulation Speed: %.2f accesses/second\n\n", (end_offset - start_offset) / elapsed);
+
+    PROF_REPORT();
 
     free_memory_trace(traces);
+    line_trace_free(line_trace);
     free_gpu_memory_system(system);
 
     return 0;
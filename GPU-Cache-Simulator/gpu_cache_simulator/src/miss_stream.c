@@ -0,0 +1,183 @@
+#define _POSIX_C_SOURCE 200809L
+#include "miss_stream.h"
+#include "cache_layer.h"
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#define MISS_STREAM_BUFFER_RECORDS 4096
+
+static void put_le(uint8_t* out, uint64_t value, int bytes) {
+    for (int i = 0; i < bytes; i++) out[i] = (uint8_t)(value >> (8 * i));
+}
+
+static uint64_t get_le(const uint8_t* in, int bytes) {
+    uint64_t value = 0;
+    for (int i = 0; i < bytes; i++) value |= (uint64_t)in[i] << (8 * i);
+    return value;
+}
+
+miss_stream_t* miss_stream_open(const char* path) {
+    miss_stream_t* stream = (miss_stream_t*)malloc(sizeof(miss_stream_t));
+    if (!stream) return NULL;
+
+    stream->file = fopen(path, "wb");
+    if (!stream->file) {
+        printf("Error: Cannot open miss stream file %s for writing\n", path);
+        free(stream);
+        return NULL;
+    }
+    setvbuf(stream->file, NULL, _IOFBF, MISS_STREAM_BUFFER_RECORDS * MISS_STREAM_RECORD_SIZE);
+
+    uint8_t header[8];
+    put_le(header, MISS_STREAM_MAGIC, 4);
+    put_le(header + 4, MISS_STREAM_VERSION, 4);
+    fwrite(header, 1, sizeof(header), stream->file);
+
+    stream->records = 0;
+    stream->writebacks = 0;
+    return stream;
+}
+
+void miss_stream_record(miss_stream_t* stream, uint64_t address, miss_record_kind_t kind,
+                        const memory_access_t* origin) {
+    uint8_t rec[MISS_STREAM_RECORD_SIZE];
+    put_le(rec, address, 8);
+    put_le(rec + 8, origin->thread_id, 2);
+    rec[10] = (uint8_t)origin->block_id;
+    rec[11] = (uint8_t)(kind | (origin->stream_id % 64) << 2);
+    fwrite(rec, 1, sizeof(rec), stream->file);
+
+    stream->records++;
+    if (kind == MISS_RECORD_WRITEBACK) stream->writebacks++;
+}
+
+void miss_stream_close(miss_stream_t* stream) {
+    if (!stream) return;
+    if (stream->file) fclose(stream->file);
+    free(stream);
+}
+
+// Opens a stream for replay, positioned after a validated header
+static FILE* miss_stream_open_replay(const char* path) {
+    FILE* file = fopen(path, "rb");
+    if (!file) {
+        printf("Error: Cannot open miss stream file %s\n", path);
+        return NULL;
+    }
+
+    uint8_t header[8];
+    if (fread(header, 1, sizeof(header), file) != sizeof(header) ||
+        get_le(header, 4) != MISS_STREAM_MAGIC || get_le(header + 4, 4) != MISS_STREAM_VERSION) {
+        printf("Error: %s is not a version %d miss stream\n", path, MISS_STREAM_VERSION);
+        fclose(file);
+        return NULL;
+    }
+    return file;
+}
+
+// Replays the records of file whose target slice is congruent to part mod parts
+static int miss_stream_replay_part(FILE* file, cache_layer_t* target, uint32_t part, uint32_t parts,
+                                   miss_replay_stats_t* stats) {
+    uint8_t* buffer = (uint8_t*)malloc(MISS_STREAM_BUFFER_RECORDS * MISS_STREAM_RECORD_SIZE);
+    if (!buffer) return -1;
+
+    memset(stats, 0, sizeof(*stats));
+    size_t count;
+    while ((count = fread(buffer, MISS_STREAM_RECORD_SIZE, MISS_STREAM_BUFFER_RECORDS, file)) > 0) {
+        for (size_t i = 0; i < count; i++) {
+            const uint8_t* rec = buffer + i * MISS_STREAM_RECORD_SIZE;
+            miss_record_kind_t kind = (miss_record_kind_t)(rec[11] & 3);
+            stats->records++;
+
+            memory_access_t access = {
+                .address = get_le(rec, 8),
+                .type = (kind == MISS_RECORD_WRITE) ? ACCESS_WRITE : ACCESS_READ,
+                .thread_id = (uint32_t)get_le(rec + 8, 2),
+                .block_id = rec[10],
+                .stream_id = rec[11] >> 2
+            };
+            if (parts > 1 && cache_slice_of(target, access.address) % parts != part) continue;
+
+            // Records do not carry the dirty sectors, so a writeback covers the whole line
+            if (kind == MISS_RECORD_WRITEBACK) {
+                cache_writeback(target, access.address, UINT32_MAX, &access);
+                stats->writebacks++;
+                continue;
+            }
+
+            cache_access(target, &access);
+            stats->demand++;
+        }
+    }
+
+    free(buffer);
+    return 0;
+}
+
+int miss_stream_replay(const char* path, cache_layer_t* target, miss_replay_stats_t* stats) {
+    FILE* file = miss_stream_open_replay(path);
+    if (!file) return -1;
+    int result = miss_stream_replay_part(file, target, 0, 1, stats);
+    fclose(file);
+    return result;
+}
+
+typedef struct {
+    const char* path;
+    cache_layer_t* fork;
+    uint32_t part;
+    uint32_t parts;
+    miss_replay_stats_t stats;
+    int result;
+} miss_replay_worker_t;
+
+// One worker: its own reader over the whole stream, its own fork of the target
+static void* miss_replay_worker(void* arg) {
+    miss_replay_worker_t* worker = (miss_replay_worker_t*)arg;
+    FILE* file = miss_stream_open_replay(worker->path);
+    worker->result = -1;
+    if (file) {
+        worker->result = miss_stream_replay_part(file, worker->fork, worker->part, worker->parts, &worker->stats);
+        fclose(file);
+    }
+    return NULL;
+}
+
+int miss_stream_replay_parallel(const char* path, cache_layer_t* target, uint32_t threads,
+                                miss_replay_stats_t* stats) {
+    if (cache_layer_can_fork(target) != 0) return -1;
+    if (threads > target->num_slices) threads = target->num_slices;
+    if (threads > MISS_REPLAY_MAX_THREADS) threads = MISS_REPLAY_MAX_THREADS;
+
+    // Fail on a bad file before any thread starts
+    FILE* file = miss_stream_open_replay(path);
+    if (!file) return -1;
+    fclose(file);
+
+    miss_replay_worker_t workers[MISS_REPLAY_MAX_THREADS];
+    pthread_t tids[MISS_REPLAY_MAX_THREADS];
+    uint32_t started = 0;
+    int result = 0;
+    for (uint32_t t = 0; t < threads; t++) {
+        workers[t] = (miss_replay_worker_t){ path, cache_layer_fork(target), t, threads, { 0, 0, 0 }, -1 };
+        if (!workers[t].fork || pthread_create(&tids[t], NULL, miss_replay_worker, &workers[t]) != 0) {
+            free(workers[t].fork);
+            result = -1;
+            break;
+        }
+        started++;
+    }
+
+    memset(stats, 0, sizeof(*stats));
+    for (uint32_t t = 0; t < started; t++) {
+        pthread_join(tids[t], NULL);
+        if (workers[t].result != 0) result = -1;
+        stats->records = workers[t].stats.records; // Every worker reads the whole stream
+        stats->demand += workers[t].stats.demand;
+        stats->writebacks += workers[t].stats.writebacks;
+        cache_layer_join(target, workers[t].fork);
+    }
+    if (result != 0) printf("Error: Slice-parallel replay of %s failed\n", path);
+    return result;
+}
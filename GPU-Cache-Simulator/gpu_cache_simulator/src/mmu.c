@@ -0,0 +1,233 @@
+#include "mmu.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+
+static const uint32_t page_shift[PAGE_SIZE_CLASSES] = { 12, 16, 21 };
+static const uint32_t page_leaf_level[PAGE_SIZE_CLASSES] = { 4, 4, 3 };
+
+void mmu_config_default(mmu_config_t* config) {
+    memset(config, 0, sizeof(*config));
+    config->enabled = false;
+    config->page_size = PAGE_4K;
+    config->l1_tlb_entries = MMU_DEFAULT_L1_TLB_ENTRIES;
+    config->l1_tlb_ways = 0;
+    config->l2_tlb_entries = MMU_DEFAULT_L2_TLB_ENTRIES;
+    config->l2_tlb_ways = MMU_DEFAULT_L2_TLB_WAYS;
+    config->pwc_entries = MMU_DEFAULT_PWC_ENTRIES;
+    config->walk_latency = MMU_DEFAULT_WALK_LATENCY;
+}
+
+const char* mmu_page_size_name(page_size_t page_size) {
+    switch (page_size) {
+        case PAGE_64K: return "64K";
+        case PAGE_2M: return "2M";
+        default: return "4K";
+    }
+}
+
+int mmu_parse_page_size(const char* name, page_size_t* page_size) {
+    char upper[8] = "";
+    for (size_t i = 0; name && name[i] && i < sizeof(upper) - 1; i++) upper[i] = (char)toupper((unsigned char)name[i]);
+    for (int p = 0; p < PAGE_SIZE_CLASSES; p++) {
+        if (strcmp(upper, mmu_page_size_name((page_size_t)p)) == 0) {
+            *page_size = (page_size_t)p;
+            return 0;
+        }
+    }
+    printf("Error: Unknown page size '%s' (expected 4K, 64K or 2M)\n", name);
+    return -1;
+}
+
+int mmu_parse_region(const char* spec, mmu_config_t* config) {
+    char page[8] = "";
+    unsigned long long start = 0, end = 0;
+    if (!spec || sscanf(spec, "%7[^:]:%lli:%lli", page, &start, &end) != 3 || start >= end) {
+        printf("Error: Invalid page region '%s' (expected <4K|64K|2M>:<start>:<end>)\n", spec);
+        return -1;
+    }
+    if (config->num_regions == MMU_MAX_REGIONS) {
+        printf("Error: At most %u page regions are supported\n", MMU_MAX_REGIONS);
+        return -1;
+    }
+
+    mmu_region_t* region = &config->regions[config->num_regions];
+    if (mmu_parse_page_size(page, &region->page_size) != 0) return -1;
+    uint64_t align = 1ull << page_shift[region->page_size];
+    if (start % align || end % align) {
+        printf("Error: Page region %#llx-%#llx is not aligned to %s pages\n", start, end, page);
+        return -1;
+    }
+    region->start = start;
+    region->end = end;
+    config->num_regions++;
+    return 0;
+}
+
+int mmu_parse_tlb(const char* spec, uint32_t* entries, uint32_t* ways) {
+    unsigned int n = 0, w = 0;
+    int fields = spec ? sscanf(spec, "%u:%u", &n, &w) : 0;
+    if (fields < 1 || n == 0 || (fields == 2 && (w == 0 || w > n || n % w != 0))) {
+        printf("Error: Invalid TLB geometry '%s' (expected <entries>[:ways], ways dividing entries)\n", spec);
+        return -1;
+    }
+    *entries = n;
+    *ways = fields == 2 ? w : 0;
+    return 0;
+}
+
+// A TLB-like structure: LRU, one "byte" per entry, keys as addresses
+static cache_layer_t* mmu_structure_create(const char* name, uint32_t entries, uint32_t ways, uint32_t latency) {
+    return cache_layer_create(name, entries, 1, ways ? ways : entries, REPLACEMENT_LRU, latency);
+}
+
+mmu_t* mmu_create(const mmu_config_t* config) {
+    mmu_t* mmu = (mmu_t*)calloc(1, sizeof(mmu_t));
+    if (!mmu) return NULL;
+    mmu->config = *config;
+
+    bool ok = true;
+    for (uint32_t i = 0; i < MAX_BLOCKS; i++) {
+        char name[32];
+        snprintf(name, sizeof(name), "L1 TLB (SM %u)", i);
+        mmu->l1_tlbs[i] = mmu_structure_create(name, config->l1_tlb_entries, config->l1_tlb_ways,
+            MMU_DEFAULT_L1_TLB_LATENCY);
+        ok &= mmu->l1_tlbs[i] != NULL;
+    }
+    mmu->l2_tlb = mmu_structure_create("L2 TLB (Shared)", config->l2_tlb_entries, config->l2_tlb_ways,
+        MMU_DEFAULT_L2_TLB_LATENCY);
+    ok &= mmu->l2_tlb != NULL;
+    if (config->pwc_entries) {
+        mmu->pwc = mmu_structure_create("Page-Walk Cache", config->pwc_entries, 0, MMU_DEFAULT_PWC_LATENCY);
+        ok &= mmu->pwc != NULL;
+    }
+
+    if (!ok) {
+        mmu_free(mmu);
+        return NULL;
+    }
+    return mmu;
+}
+
+static page_size_t mmu_page_size_of(const mmu_t* mmu, uint64_t address) {
+    for (uint32_t i = 0; i < mmu->config.num_regions; i++) {
+        const mmu_region_t* region = &mmu->config.regions[i];
+        if (address >= region->start && address < region->end) return region->page_size;
+    }
+    return mmu->config.page_size;
+}
+
+// Keys are VPNs (or walk-level prefixes) with the page size (or level) above any address bits,
+// so structures index their sets by the page number alone
+#define MMU_KEY_CLASS_SHIFT 62
+
+// Looks up (and on a miss installs) key in one structure; warm = functional only
+static bool mmu_probe(cache_layer_t* layer, const memory_access_t* access, uint64_t key, bool warm) {
+    memory_access_t probe = *access;
+    probe.address = key;
+    probe.line_id = 0; // The key is no line of the trace
+    probe.type = ACCESS_READ;
+    return warm ? cache_warm(layer, &probe) : cache_access(layer, &probe);
+}
+
+// Shared by translation and warm-up so both leave the structures in the same state
+static uint32_t mmu_lookup(mmu_t* mmu, const memory_access_t* access, bool warm) {
+    page_size_t page_size = mmu_page_size_of(mmu, access->address);
+    uint64_t vpn_key = access->address >> page_shift[page_size] | (uint64_t)page_size << MMU_KEY_CLASS_SHIFT;
+    cache_layer_t* l1_tlb = mmu->l1_tlbs[access->block_id % MAX_BLOCKS];
+
+    uint32_t latency = l1_tlb->latency;
+    if (mmu_probe(l1_tlb, access, vpn_key, warm)) return latency;
+    latency += mmu->l2_tlb->latency;
+    if (mmu_probe(mmu->l2_tlb, access, vpn_key, warm)) return latency;
+
+    // Page walk: the walk cache is probed from the deepest upper level; every level below its
+    // hit is read (and the probes that missed leave those entries cached for the next walk)
+    uint32_t leaf = page_leaf_level[page_size];
+    uint32_t reads = leaf;
+    if (mmu->pwc) {
+        latency += mmu->pwc->latency;
+        for (uint32_t level = leaf - 1; level >= 1; level--) {
+            uint32_t shift = 12 + 9 * (MMU_WALK_LEVELS - level);
+            if (mmu_probe(mmu->pwc, access, access->address >> shift | (uint64_t)level << MMU_KEY_CLASS_SHIFT, warm)) {
+                reads = leaf - level;
+                break;
+            }
+        }
+    }
+    uint32_t walk = reads * mmu->config.walk_latency;
+
+    if (!warm) {
+        mmu->walks++;
+        mmu->walk_reads += reads;
+        mmu->walk_cycles += walk;
+    }
+    return latency + walk;
+}
+
+uint32_t mmu_translate(mmu_t* mmu, const memory_access_t* access) {
+    uint32_t latency = mmu_lookup(mmu, access, false);
+    mmu->translations++;
+    mmu->page_translations[mmu_page_size_of(mmu, access->address)]++;
+    mmu->translation_cycles += latency;
+    return latency;
+}
+
+void mmu_warm(mmu_t* mmu, const memory_access_t* access) {
+    mmu_lookup(mmu, access, true);
+}
+
+static void mmu_print_structure(const char* label, const cache_layer_t* layer, uint64_t hits, uint64_t misses) {
+    uint64_t lookups = hits + misses;
+    printf("  %s: %u entries, ", label, layer->size);
+    if (layer->num_sets == 1) printf("fully associative");
+    else printf("%u-way", layer->associativity);
+    printf(", %u cycles; Hits: %lu, Misses: %lu, Hit Rate: %.2f%%\n", layer->latency, hits, misses,
+        lookups ? (double)hits / lookups * 100.0 : 0.0);
+}
+
+void mmu_print_stats(const mmu_t* mmu) {
+    printf("Address Translation Statistics:\n");
+    printf("  Pages: %s default", mmu_page_size_name(mmu->config.page_size));
+    for (uint32_t i = 0; i < mmu->config.num_regions; i++) {
+        const mmu_region_t* region = &mmu->config.regions[i];
+        printf(", %s in %#lx-%#lx", mmu_page_size_name(region->page_size), region->start, region->end);
+    }
+    printf("\n  Translations: %lu (4K: %lu, 64K: %lu, 2M: %lu)\n", mmu->translations,
+        mmu->page_translations[PAGE_4K], mmu->page_translations[PAGE_64K], mmu->page_translations[PAGE_2M]);
+
+    uint64_t l1_hits = 0, l1_misses = 0;
+    for (uint32_t i = 0; i < MAX_BLOCKS; i++) {
+        l1_hits += mmu->l1_tlbs[i]->hits;
+        l1_misses += mmu->l1_tlbs[i]->misses;
+    }
+    char label[32];
+    snprintf(label, sizeof(label), "L1 TLBs (%u, per SM)", MAX_BLOCKS);
+    mmu_print_structure(label, mmu->l1_tlbs[0], l1_hits, l1_misses);
+    mmu_print_structure("L2 TLB (shared)", mmu->l2_tlb, mmu->l2_tlb->hits, mmu->l2_tlb->misses);
+    if (mmu->pwc) mmu_print_structure("Page-Walk Cache", mmu->pwc, mmu->pwc->hits, mmu->pwc->misses);
+
+    printf("  Page Walks: %lu, Levels Read: %lu (%.2f per walk), Walk Cycles: %lu (%u per level)\n",
+        mmu->walks, mmu->walk_reads, mmu->walks ? (double)mmu->walk_reads / mmu->walks : 0.0,
+        mmu->walk_cycles, mmu->config.walk_latency);
+    printf("  Translation Cycles: %lu (%.2f per access)\n\n", mmu->translation_cycles,
+        mmu->translations ? (double)mmu->translation_cycles / mmu->translations : 0.0);
+}
+
+void mmu_reset(mmu_t* mmu) {
+    if (!mmu) return;
+    for (uint32_t i = 0; i < MAX_BLOCKS; i++) cache_layer_reset(mmu->l1_tlbs[i]);
+    cache_layer_reset(mmu->l2_tlb);
+    cache_layer_reset(mmu->pwc);
+    mmu->translations = mmu->walks = mmu->walk_reads = mmu->walk_cycles = mmu->translation_cycles = 0;
+    memset(mmu->page_translations, 0, sizeof(mmu->page_translations));
+}
+
+void mmu_free(mmu_t* mmu) {
+    if (!mmu) return;
+    for (uint32_t i = 0; i < MAX_BLOCKS; i++) cache_layer_free(mmu->l1_tlbs[i]);
+    cache_layer_free(mmu->l2_tlb);
+    cache_layer_free(mmu->pwc);
+    free(mmu);
+}
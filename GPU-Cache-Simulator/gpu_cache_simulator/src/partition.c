@@ -0,0 +1,195 @@
+#include "partition.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+const char* partition_key_name(partition_key_t key) {
+    return key == PARTITION_BY_STREAM ? "stream" : "block";
+}
+
+int partition_parse(const char* spec, partition_key_t* key, uint32_t* count, uint32_t* ways, bool* has_split) {
+    char name[16] = "";
+    char split[128] = "";
+    unsigned int n = 0;
+
+    memset(ways, 0, PARTITION_MAX * sizeof(uint32_t));
+    if (!spec || sscanf(spec, "%15[^:]:%u:%127s", name, &n, split) < 2 || n < 1 || n > PARTITION_MAX) {
+        printf("Error: Invalid partitioning '%s' (expected block|stream:<1-%u>[:w0,w1,...])\n", spec, PARTITION_MAX);
+        return -1;
+    }
+    if (strcmp(name, "block") == 0) *key = PARTITION_BY_BLOCK;
+    else if (strcmp(name, "stream") == 0) *key = PARTITION_BY_STREAM;
+    else {
+        printf("Error: Unknown partition key '%s' (expected block or stream)\n", name);
+        return -1;
+    }
+
+    if (split[0]) {
+        char* cur = split;
+        for (uint32_t p = 0; p < n; p++) {
+            char* end;
+            ways[p] = (uint32_t)strtoul(cur, &end, 0);
+            if (end == cur || (p + 1 < n && *end != ',') || (p + 1 == n && *end != '\0')) {
+                printf("Error: Way split '%s' must list %u comma-separated counts\n", split, n);
+                return -1;
+            }
+            cur = end + 1;
+        }
+    }
+    *count = n;
+    *has_split = split[0] != '\0';
+    return 0;
+}
+
+void partition_build_masks(partition_t* part) {
+    uint32_t first = 0;
+    for (uint32_t p = 0; p < part->count; p++) {
+        uint64_t bits = part->ways[p] == 64 ? UINT64_MAX : (1ull << part->ways[p]) - 1;
+        part->masks[p] = bits << first;
+        first += part->ways[p];
+    }
+}
+
+partition_t* partition_create(partition_key_t key, uint32_t count, const uint32_t* ways,
+                              uint32_t associativity, uint32_t num_sets, uint32_t interval) {
+    if (count == 0 || count > PARTITION_MAX || associativity < count || associativity > PARTITION_MAX_WAYS) {
+        printf("Error: Cannot split %u ways into %u partitions (1-%u partitions, at most %u ways)\n",
+            associativity, count, PARTITION_MAX, PARTITION_MAX_WAYS);
+        return NULL;
+    }
+
+    partition_t* part = (partition_t*)calloc(1, sizeof(partition_t));
+    if (!part) return NULL;
+    part->key = key;
+    part->count = count;
+    part->associativity = associativity;
+    part->interval = interval;
+    part->num_sets = num_sets;
+
+    uint32_t total = 0;
+    bool empty = false;
+    for (uint32_t p = 0; p < count; p++) {
+        part->ways[p] = ways ? ways[p] : associativity / count + (p < associativity % count);
+        empty |= part->ways[p] == 0;
+        total += part->ways[p];
+    }
+    if (empty || total != associativity) {
+        printf("Error: Way split must give every partition at least one way and sum to %u\n", associativity);
+        free(part);
+        return NULL;
+    }
+    memcpy(part->initial_ways, part->ways, sizeof(part->ways));
+    partition_build_masks(part);
+
+    if (interval) {
+        part->umon_sets = (num_sets + UMON_SAMPLE_RATIO - 1) / UMON_SAMPLE_RATIO;
+        part->umon_tags = (uint64_t*)calloc((size_t)count * part->umon_sets * associativity, sizeof(uint64_t));
+        part->umon_hits = (uint64_t*)calloc((size_t)count * associativity, sizeof(uint64_t));
+        if (!part->umon_tags || !part->umon_hits) {
+            partition_free(part);
+            return NULL;
+        }
+    }
+    return part;
+}
+
+// Utility monitor: LRU stack of the partition's own tags in a sampled set, as if it had every way
+static void umon_access(partition_t* part, uint32_t p, uint64_t block_addr) {
+    uint32_t set = block_addr % part->num_sets;
+    if (set % UMON_SAMPLE_RATIO != 0) return;
+
+    uint32_t assoc = part->associativity;
+    uint64_t* stack = part->umon_tags + ((size_t)p * part->umon_sets + set / UMON_SAMPLE_RATIO) * assoc;
+    uint64_t tag = block_addr / part->num_sets + 1;
+
+    uint32_t pos = 0;
+    while (pos < assoc - 1 && stack[pos] != tag) pos++;
+    if (stack[pos] == tag) part->umon_hits[(size_t)p * assoc + pos]++;
+    memmove(stack + 1, stack, pos * sizeof(uint64_t));
+    stack[0] = tag;
+}
+
+// Lookahead allocation: repeatedly give the partition with the highest marginal utility per
+// way the run of ways that achieves it, starting from one way each
+static void ucp_repartition(partition_t* part) {
+    uint32_t assoc = part->associativity;
+    uint32_t alloc[PARTITION_MAX];
+    uint32_t balance = assoc - part->count;
+    for (uint32_t p = 0; p < part->count; p++) alloc[p] = 1;
+
+    while (balance > 0) {
+        double best_mu = -1.0;
+        uint32_t best_p = 0, best_k = 1;
+        for (uint32_t p = 0; p < part->count; p++) {
+            const uint64_t* hits = part->umon_hits + (size_t)p * assoc;
+            uint64_t gain = 0;
+            for (uint32_t k = 1; k <= balance; k++) {
+                gain += hits[alloc[p] + k - 1];
+                double mu = (double)gain / k;
+                if (mu > best_mu) {
+                    best_mu = mu;
+                    best_p = p;
+                    best_k = k;
+                }
+            }
+        }
+        alloc[best_p] += best_k;
+        balance -= best_k;
+    }
+
+    for (uint32_t p = 0; p < part->count; p++) part->ways[p] = alloc[p];
+    partition_build_masks(part);
+
+    // Halve the histograms so the next decision favours recent behaviour
+    for (size_t i = 0; i < (size_t)part->count * assoc; i++) part->umon_hits[i] /= 2;
+    part->repartitions++;
+}
+
+void partition_observe(partition_t* part, const memory_access_t* access, uint64_t block_addr, bool hit) {
+    uint32_t p = partition_of(part, access);
+    if (hit) part->hits[p]++;
+    else part->misses[p]++;
+
+    if (!part->interval) return;
+    umon_access(part, p, block_addr);
+    if (++part->since_repartition >= part->interval) {
+        part->since_repartition = 0;
+        ucp_repartition(part);
+    }
+}
+
+void partition_print_stats(const partition_t* part, const uint32_t* occupancy, uint32_t total_lines) {
+    printf("  Partitions: %u by %s", part->count, partition_key_name(part->key));
+    if (part->interval) printf(", UCP every %u accesses (%lu repartitions)", part->interval, part->repartitions);
+    printf("\n");
+
+    uint32_t first = 0;
+    for (uint32_t p = 0; p < part->count; p++) {
+        uint64_t accesses = part->hits[p] + part->misses[p];
+        printf("    P%u: ways %2u-%-2u Hits: %lu, Misses: %lu, Hit Rate: %.2f%%, Occupancy: %u lines (%.2f%%)\n",
+            p, first, first + part->ways[p] - 1, part->hits[p], part->misses[p],
+            accesses ? (double)part->hits[p] / accesses * 100.0 : 0.0,
+            occupancy[p], total_lines ? (double)occupancy[p] / total_lines * 100.0 : 0.0);
+        first += part->ways[p];
+    }
+}
+
+void partition_reset(partition_t* part) {
+    if (!part) return;
+    memcpy(part->ways, part->initial_ways, sizeof(part->ways));
+    partition_build_masks(part);
+    memset(part->hits, 0, sizeof(part->hits));
+    memset(part->misses, 0, sizeof(part->misses));
+    part->since_repartition = part->repartitions = 0;
+    if (part->umon_tags) {
+        memset(part->umon_tags, 0, (size_t)part->count * part->umon_sets * part->associativity * sizeof(uint64_t));
+        memset(part->umon_hits, 0, (size_t)part->count * part->associativity * sizeof(uint64_t));
+    }
+}
+
+void partition_free(partition_t* part) {
+    if (!part) return;
+    free(part->umon_tags);
+    free(part->umon_hits);
+    free(part);
+}
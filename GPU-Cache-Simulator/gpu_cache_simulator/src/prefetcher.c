@@ -0,0 +1,203 @@
+#include "prefetcher.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// --- Next-Line ---
+
+static uint32_t next_line_observe(prefetcher_t* pf, const prefetch_event_t* event, uint64_t* out, uint32_t max) {
+    // Tagged next-line: trigger on misses and on the first use of a prefetched block, so a
+    // sequential walk keeps running ahead instead of missing every degree blocks
+    if (event->hit && !event->prefetch_hit) return 0;
+
+    uint32_t n = 0;
+    for (uint32_t k = 1; k <= pf->degree && n < max; k++) out[n++] = event->block_addr + k;
+    return n;
+}
+
+// --- Stride (Reference Prediction Table) ---
+// The trace carries no PC, so the table is indexed by (block_id, thread_id) instead
+
+typedef struct {
+    uint32_t key;        // block_id * MAX_THREADS + thread_id + 1, 0 = empty
+    uint8_t confidence;  // Saturating count of repeats of stride
+    uint64_t last_block;
+    int64_t stride;
+} stride_entry_t;
+
+static uint32_t stride_observe(prefetcher_t* pf, const prefetch_event_t* event, uint64_t* out, uint32_t max) {
+    stride_entry_t* table = (stride_entry_t*)pf->state;
+    uint32_t key = event->access->block_id * MAX_THREADS + event->access->thread_id + 1;
+    stride_entry_t* e = &table[(uint32_t)(key * 2654435761u) >> (32 - STRIDE_TABLE_BITS)]; // Fibonacci hash
+
+    if (e->key != key) {
+        e->key = key;
+        e->last_block = event->block_addr;
+        e->stride = 0;
+        e->confidence = 0;
+        return 0;
+    }
+
+    int64_t delta = (int64_t)(event->block_addr - e->last_block);
+    if (delta == 0) return 0; // Same block again, nothing learned
+    e->last_block = event->block_addr;
+
+    if (delta == e->stride) {
+        if (e->confidence < 3) e->confidence++;
+    } else {
+        e->stride = delta;
+        e->confidence = 0;
+        return 0;
+    }
+
+    uint32_t n = 0;
+    for (uint32_t k = 1; k <= pf->degree && n < max; k++) {
+        int64_t target = (int64_t)event->block_addr + e->stride * (int64_t)k;
+        if (target < 0) break;
+        out[n++] = (uint64_t)target;
+    }
+    return n;
+}
+
+// --- Stream ---
+
+typedef struct {
+    bool valid;
+    int8_t direction;  // +1 ascending, -1 descending, 0 not yet known
+    uint8_t confidence;
+    uint64_t head;     // Most recent block of the stream
+    uint64_t last_use;
+} stream_entry_t;
+
+typedef struct {
+    stream_entry_t entries[STREAM_TABLE_SIZE];
+    uint64_t clock;
+} stream_state_t;
+
+static uint32_t stream_observe(prefetcher_t* pf, const prefetch_event_t* event, uint64_t* out, uint32_t max) {
+    if (event->hit && !event->prefetch_hit) return 0;
+
+    stream_state_t* st = (stream_state_t*)pf->state;
+    uint64_t block = event->block_addr;
+    uint64_t window = STREAM_WINDOW + pf->degree;
+    st->clock++;
+
+    stream_entry_t* match = NULL;
+    stream_entry_t* lru = &st->entries[0];
+    for (uint32_t i = 0; i < STREAM_TABLE_SIZE; i++) {
+        stream_entry_t* e = &st->entries[i];
+        if (e->valid && block != e->head &&
+            (block > e->head ? block - e->head : e->head - block) <= window) {
+            match = e;
+            break;
+        }
+        // Replacement candidate: first free entry, else least recently extended
+        if (lru->valid && (!e->valid || e->last_use < lru->last_use)) lru = e;
+    }
+
+    if (!match) {
+        lru->valid = true;
+        lru->direction = 0;
+        lru->confidence = 0;
+        lru->head = block;
+        lru->last_use = st->clock;
+        return 0;
+    }
+
+    int8_t direction = block > match->head ? 1 : -1;
+    if (direction == match->direction) {
+        if (match->confidence < 3) match->confidence++;
+    } else {
+        match->direction = direction;
+        match->confidence = 1;
+    }
+    match->head = block;
+    match->last_use = st->clock;
+    if (match->confidence < 2) return 0;
+
+    uint32_t n = 0;
+    for (uint32_t k = 1; k <= pf->degree && n < max; k++) {
+        if (direction < 0 && block < k) break;
+        out[n++] = direction > 0 ? block + k : block - k;
+    }
+    return n;
+}
+
+// --- Construction ---
+
+const char* prefetcher_name(prefetcher_type_t type) {
+    switch (type) {
+        case PREFETCH_NEXT_LINE: return "next-line";
+        case PREFETCH_STRIDE:    return "stride";
+        case PREFETCH_STREAM:    return "stream";
+        default:                 return "none";
+    }
+}
+
+int prefetcher_parse(const char* spec, prefetcher_type_t* type, uint32_t* degree) {
+    char name[16] = "";
+    unsigned int deg = PREFETCH_DEFAULT_DEGREE;
+
+    if (!spec || sscanf(spec, "%15[^:]:%u", name, &deg) < 1 || deg == 0 || deg > PREFETCH_MAX_DEGREE) {
+        printf("Error: Invalid prefetcher '%s' (expected none|next-line|stride|stream[:degree])\n", spec);
+        return -1;
+    }
+
+    for (int t = PREFETCH_NONE; t <= PREFETCH_STREAM; t++) {
+        if (strcmp(name, prefetcher_name((prefetcher_type_t)t)) == 0) {
+            *type = (prefetcher_type_t)t;
+            *degree = deg;
+            return 0;
+        }
+    }
+    printf("Error: Unknown prefetcher '%s'\n", name);
+    return -1;
+}
+
+prefetcher_t* prefetcher_create(prefetcher_type_t type, uint32_t degree) {
+    if (type == PREFETCH_NONE) return NULL;
+
+    prefetcher_t* pf = (prefetcher_t*)calloc(1, sizeof(prefetcher_t));
+    if (!pf) return NULL;
+    pf->type = type;
+    pf->degree = degree ? degree : PREFETCH_DEFAULT_DEGREE;
+
+    switch (type) {
+        case PREFETCH_NEXT_LINE:
+            pf->observe = next_line_observe;
+            break;
+        case PREFETCH_STRIDE:
+            pf->observe = stride_observe;
+            pf->state = calloc(STRIDE_TABLE_SIZE, sizeof(stride_entry_t));
+            break;
+        case PREFETCH_STREAM:
+            pf->observe = stream_observe;
+            pf->state = calloc(1, sizeof(stream_state_t));
+            break;
+        default:
+            break;
+    }
+
+    if (type != PREFETCH_NEXT_LINE && !pf->state) {
+        free(pf);
+        return NULL;
+    }
+    return pf;
+}
+
+size_t prefetcher_state_size(const prefetcher_t* pf) {
+    if (!pf) return 0;
+    if (pf->type == PREFETCH_STRIDE) return STRIDE_TABLE_SIZE * sizeof(stride_entry_t);
+    if (pf->type == PREFETCH_STREAM) return sizeof(stream_state_t);
+    return 0;
+}
+
+void prefetcher_reset(prefetcher_t* pf) {
+    if (pf && pf->state) memset(pf->state, 0, prefetcher_state_size(pf));
+}
+
+void prefetcher_free(prefetcher_t* pf) {
+    if (!pf) return;
+    free(pf->state);
+    free(pf);
+}
@@ -83,10 +83,31 @@ uint32_t pq_peek_min(priority_queue_t* pq) {
     return pq->heap[0].data;
 }
 
+uint32_t pq_peek_min_priority(priority_queue_t* pq) {
+    if (!pq || pq->size == 0) return UINT32_MAX;
+    return pq->heap[0].priority;
+}
+
 bool pq_is_empty(priority_queue_t* pq) {
     return pq == NULL || pq->size == 0;
 }
 
+int pq_grow(priority_queue_t* pq) {
+    uint32_t capacity = pq->capacity ? pq->capacity * 2 : 1;
+    pq_node_t* heap = (pq_node_t*)realloc(pq->heap, sizeof(pq_node_t) * capacity);
+    if (!heap) return -1;
+
+    pq->heap = heap;
+    pq->capacity = capacity;
+    return 0;
+}
+
+void pq_rebase(priority_queue_t* pq, uint32_t delta) {
+    for (uint32_t i = 0; i < pq->size; i++) {
+        pq->heap[i].priority -= delta;
+    }
+}
+
 void pq_free(priority_queue_t* pq) {
     if (!pq) return;
     
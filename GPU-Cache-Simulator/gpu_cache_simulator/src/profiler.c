@@ -0,0 +1,50 @@
+#define _POSIX_C_SOURCE 199309L
+#include "profiler.h"
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+uint64_t profiler_cycles[PROF_NUM_PHASES];
+uint64_t profiler_calls[PROF_NUM_PHASES];
+
+static const char* phase_names[PROF_NUM_PHASES] = {
+    "Trace parse",
+    "gpu_memory_access (total)",
+    "Region check",
+    "Last-line memo",
+    "Address decompose",
+    "Tag lookup",
+    "Victim select",
+    "Replacement update",
+    "Next-level access",
+};
+
+#if !(defined(__x86_64__) || defined(__i386__))
+uint64_t profiler_now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+#endif
+
+void profiler_reset(void) {
+    memset(profiler_cycles, 0, sizeof(profiler_cycles));
+    memset(profiler_calls, 0, sizeof(profiler_calls));
+}
+
+void profiler_print_report(void) {
+    // Percentages are relative to the whole gpu_memory_access time. Phases nest
+    // (Next-level access contains the lower level's own phases), so they do not sum to 100%.
+    uint64_t total = profiler_cycles[PROF_GPU_ACCESS];
+
+    printf("Hot-Path Phase Profile (%s, inclusive)\n", PROFILER_UNIT);
+    printf("  %-28s %14s %16s %10s %8s\n", "Phase", "Calls", "Total", "Avg", "Share");
+    for (int i = 0; i < PROF_NUM_PHASES; i++) {
+        double avg = profiler_calls[i] ? (double)profiler_cycles[i] / profiler_calls[i] : 0.0;
+        // Trace parsing happens before the simulation loop, so it has no share of it
+        double share = (total && i != PROF_TRACE_PARSE) ? (double)profiler_cycles[i] / total * 100.0 : 0.0;
+        printf("  %-28s %14lu %16lu %10.1f %7.1f%%\n",
+            phase_names[i], profiler_calls[i], profiler_cycles[i], avg, share);
+    }
+    printf("\n");
+}
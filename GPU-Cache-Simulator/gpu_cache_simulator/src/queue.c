@@ -47,6 +47,29 @@ uint32_t queue_dequeue(queue_t* q) {
     return data;
 }
 
+bool queue_remove(queue_t* q, uint32_t data) {
+    if (!q) return false;
+    
+    queue_node_t* prev = NULL;
+    for (queue_node_t* node = q->front; node; prev = node, node = node->next) {
+        if (node->data != data) continue;
+        
+        if (prev) {
+            prev->next = node->next;
+        } else {
+            q->front = node->next;
+        }
+        if (q->rear == node) {
+            q->rear = prev;
+        }
+        
+        free(node);
+        q->size--;
+        return true;
+    }
+    return false;
+}
+
 bool queue_is_empty(queue_t* q) {
     return q == NULL || q->front == NULL;
 }
@@ -0,0 +1,146 @@
+#include "sampling.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+int sampling_parse(const char* spec, sampling_config_t* config) {
+    if (!spec || !config) return -1;
+
+    memset(config, 0, sizeof(*config));
+    char mode[16] = "";
+    unsigned long long ff, wu, m;
+
+    int fields = sscanf(spec, "%llu:%llu:%llu:%15s", &ff, &wu, &m, mode);
+    if (fields < 3 || m == 0) {
+        printf("Error: Invalid sampling pattern '%s' (expected FF:WARMUP:MEASURE[:skip])\n", spec);
+        return -1;
+    }
+
+    config->fast_forward = ff;
+    config->warmup = wu;
+    config->measure = m;
+    config->skip = (fields == 4 && strcmp(mode, "skip") == 0);
+    return 0;
+}
+
+static void running_stat_add(running_stat_t* stat, double value) {
+    stat->n++;
+    double delta = value - stat->mean;
+    stat->mean += delta / stat->n;
+    stat->m2 += delta * (value - stat->mean);
+}
+
+// Two-sided 95% Student t quantiles for 1..30 degrees of freedom; normal beyond that
+static double t_quantile_95(uint64_t dof) {
+    static const double table[30] = {
+        12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+        2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+        2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042
+    };
+    if (dof == 0) return 0.0;
+    return dof <= 30 ? table[dof - 1] : 1.960;
+}
+
+// Half-width of the 95% confidence interval of the mean
+static double running_stat_ci(const running_stat_t* stat) {
+    if (stat->n < 2) return 0.0;
+    double stddev = sqrt(stat->m2 / (stat->n - 1));
+    return t_quantile_95(stat->n - 1) * stddev / sqrt((double)stat->n);
+}
+
+static void take_snapshot(gpu_memory_system_t* system, gpu_stats_snapshot_t* snap) {
+    snap->accesses = system->total_accesses;
+    snap->cycles = system->total_latency;
+    snap->l1_hits = system->l1_cache->hits;
+    snap->l1_misses = system->l1_cache->misses;
+    snap->l2_hits = system->l2_cache->hits;
+    snap->l2_misses = system->l2_cache->misses;
+    snap->global_accesses = system->global_memory_accesses;
+}
+
+static void close_window(sampler_t* sampler, gpu_memory_system_t* system) {
+    gpu_stats_snapshot_t now;
+    take_snapshot(system, &now);
+    const gpu_stats_snapshot_t* start = &sampler->window_start;
+    sampler->in_window = false;
+
+    uint64_t accesses = now.accesses - start->accesses;
+    if (accesses == 0) return;
+
+    running_stat_add(&sampler->amat, (double)(now.cycles - start->cycles) / accesses);
+    running_stat_add(&sampler->global_rate, (double)(now.global_accesses - start->global_accesses) / accesses);
+
+    // Windows that never reached a level carry no information about its hit rate
+    uint64_t l1_hits = now.l1_hits - start->l1_hits;
+    uint64_t l1_total = l1_hits + (now.l1_misses - start->l1_misses);
+    if (l1_total > 0) running_stat_add(&sampler->l1_hit_rate, (double)l1_hits / l1_total * 100.0);
+
+    uint64_t l2_hits = now.l2_hits - start->l2_hits;
+    uint64_t l2_total = l2_hits + (now.l2_misses - start->l2_misses);
+    if (l2_total > 0) running_stat_add(&sampler->l2_hit_rate, (double)l2_hits / l2_total * 100.0);
+}
+
+void sampler_init(sampler_t* sampler, const sampling_config_t* config) {
+    memset(sampler, 0, sizeof(*sampler));
+    sampler->config = *config;
+}
+
+sample_phase_t sampler_next_phase(sampler_t* sampler, gpu_memory_system_t* system) {
+    const sampling_config_t* cfg = &sampler->config;
+    uint64_t period = cfg->fast_forward + cfg->warmup + cfg->measure;
+    uint64_t pos = sampler->position++ % period;
+
+    // The measure window occupies the tail of each period
+    if (pos == 0 && sampler->in_window) close_window(sampler, system);
+    if (pos == cfg->fast_forward + cfg->warmup) {
+        take_snapshot(system, &sampler->window_start);
+        sampler->in_window = true;
+    }
+
+    if (pos < cfg->fast_forward) {
+        sampler->fast_forwarded++;
+        return SAMPLE_PHASE_FAST_FORWARD;
+    }
+    if (pos < cfg->fast_forward + cfg->warmup) {
+        sampler->warmed++;
+        return SAMPLE_PHASE_WARMUP;
+    }
+    sampler->measured++;
+    return SAMPLE_PHASE_MEASURE;
+}
+
+void sampler_finish(sampler_t* sampler, gpu_memory_system_t* system) {
+    if (sampler->in_window) close_window(sampler, system);
+}
+
+static void print_estimate(const char* label, const running_stat_t* stat, const char* unit) {
+    if (stat->n == 0) {
+        printf("  %-22s n/a\n", label);
+        return;
+    }
+    printf("  %-22s %.2f +/- %.2f%s (%lu windows)\n", label, stat->mean, running_stat_ci(stat), unit, stat->n);
+}
+
+void sampler_print_report(sampler_t* sampler, uint64_t total_accesses) {
+    const sampling_config_t* cfg = &sampler->config;
+
+    printf("\nSampled Simulation Estimates (95%% confidence)\n");
+    printf("=============================================\n");
+    printf("Pattern: fast-forward %lu (%s), warmup %lu, measure %lu\n",
+        cfg->fast_forward, cfg->skip ? "skipped" : "functional warming", cfg->warmup, cfg->measure);
+    printf("Accesses: %lu fast-forwarded, %lu warmup, %lu measured (%.1f%% of trace)\n",
+        sampler->fast_forwarded, sampler->warmed, sampler->measured,
+        total_accesses ? (double)sampler->measured / total_accesses * 100.0 : 0.0);
+
+    print_estimate("AMAT:", &sampler->amat, " cycles");
+    print_estimate("L1 Hit Rate:", &sampler->l1_hit_rate, "%");
+    print_estimate("L2 Hit Rate:", &sampler->l2_hit_rate, "%");
+
+    if (sampler->amat.n > 0) {
+        printf("  %-22s %.0f +/- %.0f\n", "Total Cycles:",
+            sampler->amat.mean * total_accesses, running_stat_ci(&sampler->amat) * total_accesses);
+        printf("  %-22s %.0f +/- %.0f\n", "Global Mem Accesses:",
+            sampler->global_rate.mean * total_accesses, running_stat_ci(&sampler->global_rate) * total_accesses);
+    }
+}
@@ -0,0 +1,103 @@
+#include "scratchpad.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+scratchpad_t* scratchpad_create(const char* name, uint32_t size, uint32_t latency) {
+    scratchpad_t* sp = (scratchpad_t*)calloc(1, sizeof(scratchpad_t));
+    if (!sp) return NULL;
+
+    strncpy(sp->name, name, sizeof(sp->name) - 1);
+    sp->size = size;
+    sp->latency = latency;
+    return sp;
+}
+
+static void scratchpad_close(scratchpad_t* sp, scratchpad_request_t* req) {
+    if (!req->open) return;
+    sp->requests++;
+    sp->degree_sum += req->degree;
+    sp->histogram[req->degree]++;
+    req->open = false;
+}
+
+uint32_t scratchpad_access(scratchpad_t* sp, const memory_access_t* access, uint32_t offset) {
+    scratchpad_request_t* req = &sp->pending[access->block_id % MAX_BLOCKS];
+    uint32_t warp = access->thread_id / SCRATCHPAD_WARP_SIZE;
+    uint32_t lane_bit = 1u << (access->thread_id % SCRATCHPAD_WARP_SIZE);
+    sp->accesses++;
+
+    // A different warp, a different operation or a lane issuing again ends the request
+    if (req->open && (req->warp != warp || req->type != access->type || (req->lanes & lane_bit))) {
+        scratchpad_close(sp, req);
+    }
+
+    if (!req->open) {
+        memset(req, 0, sizeof(*req));
+        req->open = true;
+        req->warp = warp;
+        req->type = access->type;
+    }
+    req->lanes |= lane_bit;
+
+    // A lane completes in the pass that serves its word: the n-th distinct word of a bank is read
+    // in pass n, and lanes sharing a word get it by broadcast in the same pass
+    uint64_t word = (offset % sp->size) / SCRATCHPAD_BANK_WIDTH;
+    uint32_t pass = 0;
+    for (uint32_t i = 0; i < req->num_words; i++) {
+        if (req->words[i] == word) {
+            pass = req->word_pass[i];
+            sp->broadcasts++;
+            break;
+        }
+    }
+
+    if (pass == 0) {
+        uint32_t bank = (uint32_t)(word % SCRATCHPAD_BANKS);
+        pass = ++req->bank_words[bank];
+        req->words[req->num_words] = word;
+        req->word_pass[req->num_words++] = (uint8_t)pass;
+        if (pass > req->degree) {
+            req->degree = pass;
+            if (pass > 1) sp->conflict_cycles += SCRATCHPAD_REPLAY_CYCLES;
+        }
+    }
+    return sp->latency + (pass - 1) * SCRATCHPAD_REPLAY_CYCLES;
+}
+
+void scratchpad_flush(scratchpad_t* sp) {
+    for (uint32_t b = 0; b < MAX_BLOCKS; b++) scratchpad_close(sp, &sp->pending[b]);
+}
+
+void scratchpad_print_stats(scratchpad_t* sp) {
+    scratchpad_flush(sp);
+
+    printf("%s Statistics:\n", sp->name);
+    printf("  Size: %u KB per thread block, Banks: %u x %u bytes\n",
+        sp->size / 1024, SCRATCHPAD_BANKS, SCRATCHPAD_BANK_WIDTH);
+    printf("  Accesses: %lu, Warp Requests: %lu (%.2f lanes/request)\n", sp->accesses, sp->requests,
+        sp->requests ? (double)sp->accesses / sp->requests : 0.0);
+    printf("  Broadcast Lanes: %lu\n", sp->broadcasts);
+    printf("  Avg Conflict Degree: %.2f, Serialization Cycles: %lu\n",
+        sp->requests ? (double)sp->degree_sum / sp->requests : 0.0, sp->conflict_cycles);
+    if (sp->requests) {
+        printf("  Conflict Histogram (requests by ways):\n");
+        for (uint32_t d = 1; d <= SCRATCHPAD_BANKS; d++) {
+            if (sp->histogram[d] == 0) continue;
+            printf("    %2u-way: %lu (%.2f%%)\n", d, sp->histogram[d], (double)sp->histogram[d] / sp->requests * 100.0);
+        }
+    }
+    printf("  Latency: %u cycles (+%u per serialized pass)\n\n", sp->latency, SCRATCHPAD_REPLAY_CYCLES);
+}
+
+void scratchpad_reset(scratchpad_t* sp) {
+    if (!sp) return;
+    memset(sp->pending, 0, sizeof(sp->pending));
+    sp->accesses = sp->requests = sp->broadcasts = 0;
+    sp->conflict_cycles = sp->degree_sum = 0;
+    memset(sp->histogram, 0, sizeof(sp->histogram));
+}
+
+void scratchpad_free(scratchpad_t* sp) {
+    free(sp);
+}
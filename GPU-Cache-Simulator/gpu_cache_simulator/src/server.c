@@ -0,0 +1,597 @@
+#define _POSIX_C_SOURCE 200809L
+#include "server.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <errno.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+
+#define SERVER_ERROR_SIZE 256
+
+// --- Trace Sources ---
+
+// A parsed trace file, shared by the jobs that name it
+typedef struct {
+    char* path;            // NULL = free slot
+    off_t size;
+    struct timespec mtime;
+    memory_trace_t* traces;
+    uint32_t count;
+    uint32_t refs;         // Jobs currently reading it
+    uint64_t last_use;
+} trace_entry_t;
+
+// The records one job reads: a cache entry, a private copy or a mapped shared-memory object
+typedef struct {
+    const memory_trace_t* traces;
+    uint32_t count;
+    trace_entry_t* entry;
+    memory_trace_t* owned; // Parsed but not cacheable (every slot in use)
+    void* mapping;
+    size_t mapping_size;
+    bool cached;           // Already parsed by an earlier job
+} job_trace_t;
+
+typedef struct server_t server_t;
+
+typedef struct {
+    server_t* server;
+    pthread_t tid;
+    gpu_memory_system_t* system; // Kept between jobs...
+    gpu_system_config_t config;  // ... with the configuration it was built for
+    int fd;                      // Connection being served, -1 when idle
+} server_worker_t;
+
+struct server_t {
+    const server_config_t* config;
+    int listen_fd;
+    pthread_mutex_t lock;
+    pthread_cond_t work; // A connection was queued, or stopping
+    int pending[SERVER_MAX_PENDING];
+    uint32_t pending_head;
+    uint32_t pending_count;
+    bool stopping;
+    uint64_t jobs;
+    uint64_t failed_jobs;
+    uint64_t cache_clock;
+    trace_entry_t cache[SERVER_TRACE_CACHE_SIZE];
+    server_worker_t workers[SERVER_MAX_WORKERS];
+};
+
+// --- JSON Replies ---
+
+typedef struct {
+    char* data;
+    size_t len;
+    size_t cap;
+    bool failed;  // Out of memory: the reply is incomplete and must be replaced by an error
+} json_buffer_t;
+
+static void json_printf(json_buffer_t* out, const char* fmt, ...) {
+    if (out->failed) return;
+    va_list args;
+    va_start(args, fmt);
+    int n = vsnprintf(out->data + out->len, out->cap - out->len, fmt, args);
+    va_end(args);
+    if (n < 0) return;
+    if (out->len + (size_t)n >= out->cap) {
+        size_t cap = out->cap * 2 > out->len + n + 1 ? out->cap * 2 : out->len + n + 1;
+        char* data = (char*)realloc(out->data, cap);
+        if (!data) {
+            out->failed = true; // len is left at the end of the last complete write
+            return;
+        }
+        out->data = data;
+        out->cap = cap;
+        va_start(args, fmt);
+        vsnprintf(out->data + out->len, out->cap - out->len, fmt, args);
+        va_end(args);
+    }
+    out->len += (size_t)n;
+}
+
+static void json_string(json_buffer_t* out, const char* s) {
+    json_printf(out, "\"");
+    for (; *s; s++) {
+        if (*s == '"' || *s == '\\') json_printf(out, "\\%c", *s);
+        else if ((unsigned char)*s < 0x20) json_printf(out, "\\u%04x", (unsigned char)*s);
+        else json_printf(out, "%c", *s);
+    }
+    json_printf(out, "\"");
+}
+
+static void json_error(json_buffer_t* out, const char* message) {
+    out->len = 0;
+    out->failed = false;
+    json_printf(out, "{\"ok\":false,\"error\":");
+    json_string(out, message);
+    json_printf(out, "}");
+}
+
+static void json_layer(json_buffer_t* out, const char* key, cache_layer_t* cache) {
+    json_printf(out, ",\"%s\":{\"hits\":%lu,\"misses\":%lu,\"hit_rate\":%.4f,\"evictions\":%lu,"
+        "\"sector_misses\":%lu,\"writes\":%lu,\"bytes_fetched\":%lu,\"bytes_written_back\":%lu,"
+        "\"prefetch_fills\":%lu,\"prefetch_useful\":%lu", key, cache->hits, cache->misses,
+        get_hit_rate(cache), cache->evictions, cache->sector_misses, cache->writes, cache->bytes_fetched,
+        cache->bytes_written_back, cache->prefetch_fills, cache->prefetch_useful);
+    if (cache->set_sampling != SET_SAMPLING_NONE) json_printf(out, ",\"sampling_scale\":%.4f", get_sampling_scale(cache));
+    if (cache->victim) json_printf(out, ",\"victim_hits\":%lu", cache->victim->hits);
+    if (cache->num_slices > 1) {
+        json_printf(out, ",\"slice_accesses\":[");
+        for (uint32_t s = 0; s < cache->num_slices; s++) json_printf(out, "%s%lu", s ? "," : "", cache->slice_accesses[s]);
+        json_printf(out, "]");
+    }
+    json_printf(out, "}");
+}
+
+static void json_job_stats(json_buffer_t* out, gpu_memory_system_t* system, const char* trace_name,
+                           const job_trace_t* trace, bool reused, double elapsed) {
+    scratchpad_flush(system->shared_memory);
+    const scratchpad_t* sp = system->shared_memory;
+    const dram_t* dram = system->dram;
+
+    json_printf(out, "{\"ok\":true,\"trace\":");
+    json_string(out, trace_name);
+    json_printf(out, ",\"accesses\":%lu,\"cycles\":%lu,\"amat\":%.4f,\"register_hits\":%lu,"
+        "\"global_memory_accesses\":%lu", system->total_accesses, system->current_cycle,
+        system->total_accesses ? (double)system->total_latency / system->total_accesses : 0.0,
+        system->register_hits, system->global_memory_accesses);
+    // L2 set sampling makes cycles and AMAT estimates (see print_gpu_system_stats)
+    if (system->l2_estimated_accesses) json_printf(out, ",\"estimated_accesses\":%lu", system->l2_estimated_accesses);
+    json_printf(out, ",\"shared\":{\"accesses\":%lu,\"requests\":%lu,\"conflict_cycles\":%lu}",
+        sp->accesses, sp->requests, sp->conflict_cycles);
+    json_layer(out, "l1", system->l1_cache);
+    json_layer(out, "l2", system->l2_cache);
+    json_printf(out, ",\"dram\":{\"reads\":%lu,\"writes\":%lu,\"row_hits\":%lu,\"row_misses\":%lu,"
+        "\"row_conflicts\":%lu,\"avg_read_latency\":%.4f}", dram->reads, dram->writes, dram->row_hits,
+        dram->row_misses, dram->row_conflicts, dram->reads ? (double)dram->read_latency / dram->reads : 0.0);
+    if (system->mmu) {
+        const mmu_t* mmu = system->mmu;
+        json_printf(out, ",\"mmu\":{\"translations\":%lu,\"walks\":%lu,\"walk_reads\":%lu,\"translation_cycles\":%lu}",
+            mmu->translations, mmu->walks, mmu->walk_reads, mmu->translation_cycles);
+    }
+    json_printf(out, ",\"trace_cached\":%s,\"system_reused\":%s,\"elapsed_us\":%.0f}",
+        trace->cached ? "true" : "false", reused ? "true" : "false", elapsed * 1e6);
+}
+
+// --- Trace Cache ---
+
+static bool trace_entry_matches(const trace_entry_t* e, const char* path, const struct stat* st) {
+    return e->path && strcmp(e->path, path) == 0 && e->size == st->st_size &&
+        e->mtime.tv_sec == st->st_mtim.tv_sec && e->mtime.tv_nsec == st->st_mtim.tv_nsec;
+}
+
+// Caller holds the lock
+static trace_entry_t* trace_cache_find(server_t* server, const char* path, const struct stat* st) {
+    for (uint32_t i = 0; i < SERVER_TRACE_CACHE_SIZE; i++) {
+        trace_entry_t* e = &server->cache[i];
+        if (trace_entry_matches(e, path, st)) {
+            e->refs++;
+            e->last_use = ++server->cache_clock;
+            return e;
+        }
+    }
+    return NULL;
+}
+
+static void trace_entry_clear(trace_entry_t* e) {
+    free(e->path);
+    free_memory_trace(e->traces);
+    memset(e, 0, sizeof(*e));
+}
+
+static int trace_acquire_file(server_t* server, const char* path, job_trace_t* out, char* error) {
+    struct stat st;
+    if (stat(path, &st) != 0) {
+        snprintf(error, SERVER_ERROR_SIZE, "Cannot open trace file %s", path);
+        return -1;
+    }
+
+    pthread_mutex_lock(&server->lock);
+    out->entry = trace_cache_find(server, path, &st);
+    pthread_mutex_unlock(&server->lock);
+    if (out->entry) {
+        out->cached = true;
+        out->traces = out->entry->traces;
+        out->count = out->entry->count;
+        return 0;
+    }
+
+    // Parse outside the lock so other jobs keep running
+    // Line traces are expanded back to records: a worker's system changes traces from job to
+    // job, so binding the line-ID fast path is left to command-line runs
+    memory_trace_t* traces = NULL;
+    uint32_t count = 0;
+    int loaded = -1;
+    if (line_trace_is_file(path)) {
+        line_trace_t* line_trace = line_trace_load(path);
+        traces = line_trace ? line_trace_expand(line_trace) : NULL;
+        count = line_trace ? line_trace->count : 0;
+        loaded = traces ? 0 : -1;
+        line_trace_free(line_trace);
+    } else {
+        loaded = load_memory_trace(path, &traces, &count);
+    }
+    if (loaded != 0) {
+        snprintf(error, SERVER_ERROR_SIZE, "Cannot load trace file %s", path);
+        return -1;
+    }
+
+    pthread_mutex_lock(&server->lock);
+    out->entry = trace_cache_find(server, path, &st); // Another worker may have parsed it meanwhile
+    if (out->entry) {
+        free_memory_trace(traces);
+    } else {
+        // A free slot, else the least recently used entry nobody is reading
+        trace_entry_t* slot = NULL;
+        for (uint32_t i = 0; i < SERVER_TRACE_CACHE_SIZE; i++) {
+            trace_entry_t* e = &server->cache[i];
+            if (!e->path) {
+                slot = e;
+                break;
+            }
+            if (e->refs == 0 && (!slot || e->last_use < slot->last_use)) slot = e;
+        }
+        char* key = slot ? strdup(path) : NULL;
+        if (key) {
+            trace_entry_clear(slot);
+            *slot = (trace_entry_t){ key, st.st_size, st.st_mtim, traces, count, 1, ++server->cache_clock };
+            out->entry = slot;
+        } else {
+            out->owned = traces;
+            out->traces = traces;
+            out->count = count;
+        }
+    }
+    if (out->entry) {
+        out->traces = out->entry->traces;
+        out->count = out->entry->count;
+    }
+    pthread_mutex_unlock(&server->lock);
+    return 0;
+}
+
+// name is shm:<name>; the object holds count native memory_trace_t records
+static int trace_acquire_shm(const char* name, job_trace_t* out, char* error) {
+    char shm_name[128];
+    snprintf(shm_name, sizeof(shm_name), "%s%s", name[0] == '/' ? "" : "/", name);
+    int fd = shm_open(shm_name, O_RDONLY, 0);
+    struct stat st;
+    if (fd < 0 || fstat(fd, &st) != 0 || st.st_size < (off_t)sizeof(memory_trace_t)) {
+        snprintf(error, SERVER_ERROR_SIZE, "Cannot open shared-memory trace %s", shm_name);
+        if (fd >= 0) close(fd);
+        return -1;
+    }
+
+    out->mapping_size = (size_t)st.st_size;
+    out->mapping = mmap(NULL, out->mapping_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (out->mapping == MAP_FAILED) {
+        out->mapping = NULL;
+        snprintf(error, SERVER_ERROR_SIZE, "Cannot map shared-memory trace %s", shm_name);
+        return -1;
+    }
+    uint64_t count = out->mapping_size / sizeof(memory_trace_t);
+    out->traces = (const memory_trace_t*)out->mapping;
+    out->count = count > UINT32_MAX ? UINT32_MAX : (uint32_t)count;
+    return 0;
+}
+
+static void trace_release(server_t* server, job_trace_t* trace) {
+    if (trace->entry) {
+        pthread_mutex_lock(&server->lock);
+        trace->entry->refs--;
+        pthread_mutex_unlock(&server->lock);
+    }
+    free_memory_trace(trace->owned);
+    if (trace->mapping) munmap(trace->mapping, trace->mapping_size);
+}
+
+// --- Jobs ---
+
+static double server_now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// args[0] is "run", args[1] the trace, then option/value pairs
+static int server_run_job(server_worker_t* worker, char** args, int nargs, json_buffer_t* reply) {
+    server_t* server = worker->server;
+    char error[SERVER_ERROR_SIZE];
+    if (nargs < 2) {
+        json_error(reply, "Usage: run <trace|shm:name> [hierarchy options]");
+        return -1;
+    }
+
+    gpu_system_config_t config;
+    memcpy(&config, &server->config->base_config, sizeof(config));
+    for (int i = 2; i < nargs; i += 2) {
+        int parsed = i + 1 < nargs ? gpu_system_config_parse_option(&config, args[i], args[i + 1]) : 1;
+        if (parsed != 0) {
+            snprintf(error, sizeof(error), parsed < 0 ? "Invalid value for %s" : "Unknown or incomplete option %s",
+                args[i]);
+            json_error(reply, error);
+            return -1;
+        }
+    }
+    if (config.l2_size == 0 || config.l2_associativity == 0) {
+        json_error(reply, "The L2 needs a non-zero size and associativity");
+        return -1;
+    }
+
+    job_trace_t trace;
+    memset(&trace, 0, sizeof(trace));
+    const char* source = args[1];
+    int acquired = strncmp(source, "shm:", 4) == 0 ? trace_acquire_shm(source + 4, &trace, error)
+                                                    : trace_acquire_file(server, source, &trace, error);
+    if (acquired != 0) {
+        json_error(reply, error);
+        return -1;
+    }
+
+    // Same configuration as the previous job: reuse its system, otherwise build a new one
+    bool reused = worker->system && memcmp(&worker->config, &config, sizeof(config)) == 0;
+    if (reused) {
+        gpu_memory_system_reset(worker->system);
+    } else {
+        free_gpu_memory_system(worker->system);
+        worker->system = create_gpu_memory_system_with_config(&config);
+        memcpy(&worker->config, &config, sizeof(config));
+    }
+    gpu_memory_system_t* system = worker->system;
+    if (!system) {
+        trace_release(server, &trace);
+        json_error(reply, "Invalid hierarchy configuration");
+        return -1;
+    }
+
+    double start = server_now();
+    for (uint32_t i = 0; i < trace.count; i++) {
+        const memory_trace_t* t = &trace.traces[i];
+        memory_access_t access = {
+            .address = t->address,
+            .type = (t->operation == 'W') ? ACCESS_WRITE : ACCESS_READ,
+            .thread_id = t->thread_id % MAX_THREADS,
+            .block_id = t->block_id % MAX_BLOCKS,
+            .stream_id = t->stream_id
+        };
+        system->current_cycle += gpu_memory_access(system, &access);
+    }
+    double elapsed = server_now() - start;
+
+    json_job_stats(reply, system, source, &trace, reused, elapsed);
+    trace_release(server, &trace);
+    return 0;
+}
+
+// --- Connections ---
+
+static bool server_send(int fd, const char* data, size_t len) {
+    while (len > 0) {
+        ssize_t n = send(fd, data, len, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        data += n;
+        len -= (size_t)n;
+    }
+    return true;
+}
+
+// Wakes the acceptor and every worker; connections other than self stop being read
+static void server_stop(server_t* server, const server_worker_t* self) {
+    pthread_mutex_lock(&server->lock);
+    server->stopping = true;
+    for (uint32_t w = 0; w < server->config->workers; w++) {
+        const server_worker_t* worker = &server->workers[w];
+        if (worker != self && worker->fd >= 0) shutdown(worker->fd, SHUT_RD);
+    }
+    shutdown(server->listen_fd, SHUT_RDWR);
+    pthread_cond_broadcast(&server->work);
+    pthread_mutex_unlock(&server->lock);
+}
+
+static void server_serve_connection(server_worker_t* worker, int fd) {
+    server_t* server = worker->server;
+    int in_fd = dup(fd);
+    FILE* in = in_fd >= 0 ? fdopen(in_fd, "r") : NULL;
+    if (!in) {
+        if (in_fd >= 0) close(in_fd);
+        return;
+    }
+
+    json_buffer_t reply = { NULL, 0, 0, false };
+    reply.cap = 4096;
+    reply.data = (char*)malloc(reply.cap);
+    char line[SERVER_MAX_REQUEST];
+    bool open = reply.data != NULL;
+    while (open && fgets(line, sizeof(line), in)) {
+        reply.len = 0;
+        reply.failed = false;
+        bool shutdown_requested = false;
+        size_t len = strlen(line);
+
+        if (len == sizeof(line) - 1 && line[len - 1] != '\n') {
+            int c;
+            while ((c = fgetc(in)) != EOF && c != '\n') {}
+            json_error(&reply, "Request line too long");
+        } else {
+            char* args[SERVER_MAX_JOB_ARGS];
+            int nargs = 0;
+            char* save = NULL;
+            for (char* tok = strtok_r(line, " \t\r\n", &save); tok && nargs < SERVER_MAX_JOB_ARGS;
+                 tok = strtok_r(NULL, " \t\r\n", &save)) {
+                args[nargs++] = tok;
+            }
+            if (nargs == 0) continue;
+
+            if (strcmp(args[0], "run") == 0) {
+                int result = server_run_job(worker, args, nargs, &reply);
+                pthread_mutex_lock(&server->lock);
+                server->jobs++;
+                if (result != 0) server->failed_jobs++;
+                pthread_mutex_unlock(&server->lock);
+            } else if (strcmp(args[0], "status") == 0) {
+                pthread_mutex_lock(&server->lock);
+                uint32_t cached = 0;
+                for (uint32_t i = 0; i < SERVER_TRACE_CACHE_SIZE; i++) cached += server->cache[i].path != NULL;
+                json_printf(&reply, "{\"ok\":true,\"workers\":%u,\"jobs\":%lu,\"failed_jobs\":%lu,"
+                    "\"cached_traces\":%u,\"pending_connections\":%u}", server->config->workers, server->jobs,
+                    server->failed_jobs, cached, server->pending_count);
+                pthread_mutex_unlock(&server->lock);
+            } else if (strcmp(args[0], "shutdown") == 0) {
+                json_printf(&reply, "{\"ok\":true}");
+                shutdown_requested = true;
+            } else {
+                json_error(&reply, "Unknown request (expected run, status or shutdown)");
+            }
+        }
+
+        // Fits the initial buffer, so it cannot fail in turn
+        if (reply.failed) json_error(&reply, "Out of memory building the reply");
+        json_printf(&reply, "\n");
+        open = server_send(fd, reply.data, reply.len);
+        if (shutdown_requested) {
+            server_stop(server, worker);
+            break;
+        }
+    }
+
+    free(reply.data);
+    fclose(in);
+}
+
+static void* server_worker_main(void* arg) {
+    server_worker_t* worker = (server_worker_t*)arg;
+    server_t* server = worker->server;
+
+    pthread_mutex_lock(&server->lock);
+    while (true) {
+        while (!server->stopping && server->pending_count == 0) pthread_cond_wait(&server->work, &server->lock);
+        if (server->stopping) break;
+
+        int fd = server->pending[server->pending_head];
+        server->pending_head = (server->pending_head + 1) % SERVER_MAX_PENDING;
+        server->pending_count--;
+        worker->fd = fd;
+        pthread_mutex_unlock(&server->lock);
+
+        server_serve_connection(worker, fd);
+
+        pthread_mutex_lock(&server->lock);
+        worker->fd = -1;
+        close(fd);
+    }
+    pthread_mutex_unlock(&server->lock);
+    return NULL;
+}
+
+// --- Server ---
+
+static int server_listen(const char* path) {
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (strlen(path) >= sizeof(addr.sun_path)) {
+        printf("Error: Socket path %s is too long\n", path);
+        return -1;
+    }
+    strcpy(addr.sun_path, path);
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) {
+        printf("Error: Cannot create a Unix domain socket\n");
+        return -1;
+    }
+    unlink(path); // A socket left behind by a previous server
+    if (bind(fd, (struct sockaddr*)&addr, sizeof(addr)) != 0 || listen(fd, SERVER_MAX_PENDING) != 0) {
+        printf("Error: Cannot listen on %s\n", path);
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+int server_run(const server_config_t* config) {
+    if (config->workers == 0 || config->workers > SERVER_MAX_WORKERS) {
+        printf("Error: The server needs 1-%u workers\n", SERVER_MAX_WORKERS);
+        return -1;
+    }
+
+    server_t* server = (server_t*)calloc(1, sizeof(server_t));
+    if (!server) return -1;
+    server->config = config;
+    server->listen_fd = server_listen(config->socket_path);
+    if (server->listen_fd < 0) {
+        free(server);
+        return -1;
+    }
+    pthread_mutex_init(&server->lock, NULL);
+    pthread_cond_init(&server->work, NULL);
+
+    uint32_t started = 0;
+    for (; started < config->workers; started++) {
+        server_worker_t* worker = &server->workers[started];
+        worker->server = server;
+        worker->fd = -1;
+        if (pthread_create(&worker->tid, NULL, server_worker_main, worker) != 0) break;
+    }
+    if (started < config->workers) {
+        printf("Error: Started only %u of %u server workers\n", started, config->workers);
+        server_stop(server, NULL);
+    } else {
+        printf("Serving on %s with %u workers\n", config->socket_path, config->workers);
+        fflush(stdout);
+    }
+
+    while (true) {
+        int fd = accept(server->listen_fd, NULL, NULL);
+        if (fd < 0 && (errno == EINTR || errno == ECONNABORTED)) continue;
+
+        pthread_mutex_lock(&server->lock);
+        bool stopping = server->stopping;
+        bool queued = fd >= 0 && !stopping && server->pending_count < SERVER_MAX_PENDING;
+        if (queued) {
+            server->pending[(server->pending_head + server->pending_count) % SERVER_MAX_PENDING] = fd;
+            server->pending_count++;
+            pthread_cond_signal(&server->work);
+        }
+        pthread_mutex_unlock(&server->lock);
+
+        if (fd >= 0 && !queued) {
+            const char* busy = "{\"ok\":false,\"error\":\"Server busy\"}\n";
+            if (!stopping) server_send(fd, busy, strlen(busy));
+            close(fd);
+        }
+        if (stopping) break;
+        if (fd < 0) {
+            printf("Error: Accepting a connection on %s failed\n", config->socket_path);
+            server_stop(server, NULL);
+            break;
+        }
+    }
+
+    for (uint32_t w = 0; w < started; w++) pthread_join(server->workers[w].tid, NULL);
+    for (uint32_t i = 0; i < server->pending_count; i++) {
+        close(server->pending[(server->pending_head + i) % SERVER_MAX_PENDING]);
+    }
+    printf("Server stopped after %lu jobs (%lu failed)\n", server->jobs, server->failed_jobs);
+
+    for (uint32_t w = 0; w < started; w++) free_gpu_memory_system(server->workers[w].system);
+    for (uint32_t i = 0; i < SERVER_TRACE_CACHE_SIZE; i++) trace_entry_clear(&server->cache[i]);
+    close(server->listen_fd);
+    unlink(config->socket_path);
+    pthread_cond_destroy(&server->work);
+    pthread_mutex_destroy(&server->lock);
+    bool clean = started == config->workers;
+    free(server);
+    return clean ? 0 : -1;
+}
@@ -0,0 +1,553 @@
+#include "timing_engine.h"
+#include "priority_queue.h"
+#include "dram.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define NO_ENTRY UINT32_MAX
+#define EPOCH_REBASE_THRESHOLD (1u << 30) // Keep pq priorities (uint32_t cycles) far from overflow
+
+void timing_config_default(timing_config_t* config) {
+    config->warp_size = TIMING_DEFAULT_WARP_SIZE;
+    config->issue_width = TIMING_DEFAULT_ISSUE_WIDTH;
+    config->l1_mshrs = TIMING_DEFAULT_L1_MSHRS;
+    config->l2_mshrs = TIMING_DEFAULT_L2_MSHRS;
+    config->l1_bandwidth = TIMING_DEFAULT_L1_BANDWIDTH;
+    config->l2_bandwidth = TIMING_DEFAULT_L2_BANDWIDTH;
+}
+
+static inline uint64_t max_u64(uint64_t a, uint64_t b) { return a > b ? a : b; }
+
+// --- MSHR Table ---
+
+static int mshr_init(mshr_table_t* table, const char* name, uint32_t count) {
+    memset(table, 0, sizeof(*table));
+    table->name = name;
+    table->count = count ? count : 1;
+    table->wait_head = table->wait_tail = NO_ENTRY;
+    table->entries = (mshr_entry_t*)calloc(table->count, sizeof(mshr_entry_t));
+    table->index = hash_table_create(table->count * 2 + 1); // Short chains at full occupancy
+    if (!table->entries || !table->index) return -1;
+    for (uint32_t i = 0; i < table->count; i++) table->entries[i].waiters = i + 1 < table->count ? i + 1 : NO_ENTRY;
+    table->free_head = 0;
+    return 0;
+}
+
+// In-flight entry for line, or NO_ENTRY
+static inline uint32_t mshr_find(mshr_table_t* table, uint64_t line) {
+    return hash_table_lookup(table->index, line);
+}
+
+// Entry the next allocation must use, or NO_ENTRY when the table is full
+static inline uint32_t mshr_free_entry(const mshr_table_t* table) {
+    return table->free_head;
+}
+
+static mshr_entry_t* mshr_allocate(mshr_table_t* table, uint32_t idx, uint64_t line, uint64_t address,
+                                   mem_level_t level, uint64_t now) {
+    mshr_entry_t* e = &table->entries[idx];
+    table->free_head = e->waiters; // idx is the free_head
+    hash_table_insert(table->index, line, idx);
+    e->busy = true;
+    e->line = line;
+    e->address = address;
+    e->level = level;
+    e->start = now;
+    e->waiters = NO_ENTRY;
+
+    table->allocations++;
+    if (++table->active > table->peak_occupancy) table->peak_occupancy = table->active;
+    if (table->active == table->count) table->full_since = now;
+    return e;
+}
+
+static void mshr_release(mshr_table_t* table, uint32_t idx, uint64_t now) {
+    mshr_entry_t* e = &table->entries[idx];
+    table->busy_cycles += now - e->start;
+    if (table->active == table->count) table->full_cycles += now - table->full_since;
+    hash_table_delete(table->index, e->line);
+    e->busy = false;
+    e->waiters = table->free_head;
+    table->free_head = idx;
+    table->active--;
+}
+
+// --- Bandwidth Port ---
+
+static int port_init(bandwidth_port_t* port, const char* name, uint32_t bytes_per_cycle) {
+    memset(port, 0, sizeof(*port));
+    port->name = name;
+    port->bytes_per_cycle = bytes_per_cycle;
+    if (bytes_per_cycle == 0) return 0;
+
+    port->slot_cycle = (uint64_t*)malloc(TIMING_PORT_HORIZON * sizeof(uint64_t));
+    port->slot_used = (uint32_t*)calloc(TIMING_PORT_HORIZON, sizeof(uint32_t));
+    if (!port->slot_cycle || !port->slot_used) return -1;
+    for (uint32_t i = 0; i < TIMING_PORT_HORIZON; i++) port->slot_cycle[i] = UINT64_MAX;
+    return 0;
+}
+
+// Books bytes from cycle ready onward; returns the cycle the transfer has fully arrived
+static uint64_t port_transfer(bandwidth_port_t* port, uint64_t ready, uint32_t bytes) {
+    port->bytes += bytes;
+    if (port->bytes_per_cycle == 0) return ready;
+
+    uint64_t cycle = ready;
+    bool started = false;
+    for (;;) {
+        uint32_t slot = (uint32_t)(cycle % TIMING_PORT_HORIZON);
+        if (port->slot_cycle[slot] != cycle) {
+            // Slot still describes a cycle a full horizon ago - recycle it
+            port->slot_cycle[slot] = cycle;
+            port->slot_used[slot] = 0;
+        }
+
+        uint32_t avail = port->bytes_per_cycle - port->slot_used[slot];
+        if (avail > 0) {
+            if (!started) {
+                port->queue_cycles += cycle - ready;
+                started = true;
+            }
+            uint32_t take = bytes < avail ? bytes : avail;
+            port->slot_used[slot] += take;
+            bytes -= take;
+            if (bytes == 0) return cycle + 1;
+        }
+        cycle++;
+    }
+}
+
+// --- Events ---
+// Event payload: type in the top bits, warp / MSHR entry / channel index below
+
+#define EVENT_SHIFT 28
+#define EVENT_INDEX_MASK ((1u << EVENT_SHIFT) - 1)
+
+typedef enum {
+    EVENT_ISSUE,     // Warp issues its next access
+    EVENT_L1_LOOKUP, // Warp's L1 tag check done
+    EVENT_L2_LOOKUP, // L1 MSHR's request reached the L2
+    EVENT_DRAM,      // DRAM channel scheduling decision
+    EVENT_L2_FILL,   // L2 MSHR's data arrived from DRAM
+    EVENT_L1_FILL    // L1 MSHR's data arrived from the L2
+} event_type_t;
+
+typedef struct {
+    gpu_memory_system_t* system;
+    timing_stats_t* stats;
+    priority_queue_t* events;
+    uint64_t epoch;          // Cycle corresponding to priority 0
+    bool failed;
+
+    uint32_t* head;          // Per-warp FIFO of trace entries, linked through next[]
+    uint32_t* next;
+
+    // Access in flight per warp
+    uint64_t* warp_issue;
+    uint64_t* warp_lookup;   // Cycle its L1 lookup completed
+    uint64_t* warp_line;
+    uint64_t* warp_address;
+    mem_level_t* warp_level;
+    uint32_t* warp_link;     // Next warp in an L1 MSHR waiter list or the L1 wait queue
+
+    uint32_t* l1_link;       // Next L1 entry in an L2 MSHR waiter list or the L2 wait queue
+    uint64_t* tick_time;     // Per DRAM channel: the pending decision event, UINT64_MAX = none
+} timing_engine_t;
+
+static void schedule(timing_engine_t* eng, event_type_t type, uint32_t index, uint64_t at) {
+    // Superseded DRAM decisions stay queued until they expire, so the heap may need to grow
+    if (eng->events->size == eng->events->capacity && pq_grow(eng->events) != 0) {
+        eng->failed = true;
+        return;
+    }
+    pq_insert(eng->events, ((uint32_t)type << EVENT_SHIFT) | index, (uint32_t)(at - eng->epoch));
+}
+
+// --- Access Flow ---
+
+static void complete_access(timing_engine_t* eng, uint32_t w, uint64_t done) {
+    timing_stats_t* stats = eng->stats;
+    stats->accesses++;
+    stats->total_latency += done - eng->warp_issue[w];
+    if (done > stats->makespan) stats->makespan = done;
+    if (eng->head[w] != NO_ENTRY) schedule(eng, EVENT_ISSUE, w, done);
+}
+
+static void wait_enqueue(mshr_table_t* table, uint32_t* link, uint32_t idx) {
+    link[idx] = NO_ENTRY;
+    if (table->wait_tail == NO_ENTRY) table->wait_head = idx;
+    else link[table->wait_tail] = idx;
+    table->wait_tail = idx;
+}
+
+static uint32_t wait_dequeue(mshr_table_t* table, uint32_t* link) {
+    uint32_t idx = table->wait_head;
+    table->wait_head = link[idx];
+    if (table->wait_head == NO_ENTRY) table->wait_tail = NO_ENTRY;
+    return idx;
+}
+
+// Makes sure channel has a decision event no later than its earliest schedulable read
+static void dram_kick(timing_engine_t* eng, uint32_t channel, uint64_t now) {
+    uint64_t at = dram_next_decision(eng->system->dram, channel);
+    if (at == UINT64_MAX || at >= eng->tick_time[channel]) return;
+    at = max_u64(at, now);
+    eng->tick_time[channel] = at;
+    schedule(eng, EVENT_DRAM, channel, at);
+}
+
+static void l2_allocate(timing_engine_t* eng, uint32_t idx, uint32_t l1_idx, uint64_t now) {
+    mshr_entry_t* req = &eng->stats->l1_mshr.entries[l1_idx];
+    mshr_entry_t* e = mshr_allocate(&eng->stats->l2_mshr, idx, req->line, req->address, req->level, now);
+    e->waiters = l1_idx;
+    eng->l1_link[l1_idx] = NO_ENTRY;
+
+    int channel = dram_enqueue(eng->system->dram, req->address, eng->system->l2_cache->sector_size, now, idx);
+    if (channel < 0) {
+        eng->failed = true;
+        return;
+    }
+    dram_kick(eng, (uint32_t)channel, now);
+}
+
+static void l1_allocate(timing_engine_t* eng, uint32_t idx, uint32_t w, uint64_t now) {
+    mshr_entry_t* e = mshr_allocate(&eng->stats->l1_mshr, idx, eng->warp_line[w], eng->warp_address[w],
+        eng->warp_level[w], now);
+    e->waiters = w;
+    eng->warp_link[w] = NO_ENTRY;
+    schedule(eng, EVENT_L2_LOOKUP, idx, now + eng->system->l2_cache->latency);
+}
+
+static void on_issue(timing_engine_t* eng, uint32_t w, uint64_t issue, const memory_trace_t* trace) {
+    gpu_memory_system_t* system = eng->system;
+    memory_access_t access = {
+        .address = trace->address,
+        .type = (trace->operation == 'W') ? ACCESS_WRITE : ACCESS_READ,
+        .thread_id = trace->thread_id % MAX_THREADS,
+        .block_id = trace->block_id % MAX_BLOCKS,
+        .stream_id = trace->stream_id
+    };
+
+    system->current_cycle = eng->stats->base_cycle + issue; // Prefetch arrival times are relative to issue
+    uint32_t serial_latency = gpu_memory_access(system, &access);
+    eng->warp_issue[w] = issue;
+
+    if (system->last_level == MEM_LEVEL_REGISTER || system->last_level == MEM_LEVEL_SHARED) {
+        complete_access(eng, w, issue + serial_latency);
+        return;
+    }
+
+    eng->warp_line[w] = access.address / system->l1_cache->sector_size;
+    eng->warp_address[w] = access.address;
+    eng->warp_level[w] = system->last_level;
+    schedule(eng, EVENT_L1_LOOKUP, w, issue + system->last_translation + system->l1_cache->latency);
+}
+
+static void on_l1_lookup(timing_engine_t* eng, uint32_t w, uint64_t now) {
+    mshr_table_t* l1 = &eng->stats->l1_mshr;
+    eng->warp_lookup[w] = now;
+
+    // The functional model installs lines at miss time; a hit on a line still in flight waits for it
+    uint32_t pending = mshr_find(l1, eng->warp_line[w]);
+    if (pending != NO_ENTRY) {
+        l1->merges++;
+        eng->warp_link[w] = l1->entries[pending].waiters;
+        l1->entries[pending].waiters = w;
+        return;
+    }
+
+    // Hits and posted stores (write-through hits, no-allocate misses) need no MSHR
+    if (eng->warp_level[w] == MEM_LEVEL_L1) {
+        complete_access(eng, w, now);
+        return;
+    }
+
+    uint32_t idx = mshr_free_entry(l1);
+    if (idx == NO_ENTRY) wait_enqueue(l1, eng->warp_link, w);
+    else l1_allocate(eng, idx, w, now);
+}
+
+// L2 data for L1 entry idx is available at cycle ready; it arrives after the L2 -> L1 transfer
+static void l1_deliver(timing_engine_t* eng, uint32_t idx, uint64_t ready) {
+    uint64_t done = port_transfer(&eng->stats->l1_port, ready, eng->system->l1_cache->sector_size);
+    schedule(eng, EVENT_L1_FILL, idx, done);
+}
+
+static void on_l2_lookup(timing_engine_t* eng, uint32_t l1_idx, uint64_t now) {
+    mshr_table_t* l2 = &eng->stats->l2_mshr;
+    mshr_entry_t* req = &eng->stats->l1_mshr.entries[l1_idx];
+
+    uint32_t pending = mshr_find(l2, req->line);
+    if (pending != NO_ENTRY) {
+        l2->merges++;
+        eng->l1_link[l1_idx] = l2->entries[pending].waiters;
+        l2->entries[pending].waiters = l1_idx;
+        return;
+    }
+
+    if (req->level != MEM_LEVEL_GLOBAL) {
+        l1_deliver(eng, l1_idx, now);
+        return;
+    }
+
+    uint32_t idx = mshr_free_entry(l2);
+    if (idx == NO_ENTRY) wait_enqueue(l2, eng->l1_link, l1_idx);
+    else l2_allocate(eng, idx, l1_idx, now);
+}
+
+static void on_dram(timing_engine_t* eng, uint32_t channel, uint64_t now) {
+    if (eng->tick_time[channel] != now) return; // Superseded by an earlier decision
+    eng->tick_time[channel] = UINT64_MAX;
+
+    uint32_t tag;
+    uint64_t done;
+    while (dram_schedule(eng->system->dram, channel, now, &tag, &done)) {
+        uint64_t filled = port_transfer(&eng->stats->l2_port, done, eng->system->l2_cache->sector_size);
+        schedule(eng, EVENT_L2_FILL, tag, filled);
+    }
+    dram_kick(eng, channel, now);
+}
+
+static void on_l2_fill(timing_engine_t* eng, uint32_t idx, uint64_t now) {
+    mshr_table_t* l2 = &eng->stats->l2_mshr;
+    mshr_table_t* l1 = &eng->stats->l1_mshr;
+    uint32_t latency = eng->system->l2_cache->latency;
+
+    for (uint32_t e = l2->entries[idx].waiters; e != NO_ENTRY; e = eng->l1_link[e]) l1_deliver(eng, e, now);
+    mshr_release(l2, idx, now);
+
+    // Oldest waiting misses first; each may have been merged into an entry allocated since
+    while (l2->wait_head != NO_ENTRY) {
+        uint32_t e = l2->wait_head;
+        uint32_t pending = mshr_find(l2, l1->entries[e].line);
+        uint32_t free_idx = pending == NO_ENTRY ? mshr_free_entry(l2) : NO_ENTRY;
+        if (pending == NO_ENTRY && free_idx == NO_ENTRY) break;
+
+        wait_dequeue(l2, eng->l1_link);
+        l2->wait_cycles += now - (l1->entries[e].start + latency);
+        if (pending != NO_ENTRY) {
+            l2->merges++;
+            eng->l1_link[e] = l2->entries[pending].waiters;
+            l2->entries[pending].waiters = e;
+        } else {
+            l2_allocate(eng, free_idx, e, now);
+        }
+    }
+}
+
+static void on_l1_fill(timing_engine_t* eng, uint32_t idx, uint64_t now) {
+    mshr_table_t* l1 = &eng->stats->l1_mshr;
+
+    uint32_t w = l1->entries[idx].waiters;
+    while (w != NO_ENTRY) {
+        uint32_t following = eng->warp_link[w];
+        complete_access(eng, w, now);
+        w = following;
+    }
+    mshr_release(l1, idx, now);
+
+    while (l1->wait_head != NO_ENTRY) {
+        w = l1->wait_head;
+        uint32_t pending = mshr_find(l1, eng->warp_line[w]);
+        uint32_t free_idx = pending == NO_ENTRY ? mshr_free_entry(l1) : NO_ENTRY;
+        if (pending == NO_ENTRY && free_idx == NO_ENTRY) break;
+
+        wait_dequeue(l1, eng->warp_link);
+        l1->wait_cycles += now - eng->warp_lookup[w];
+        if (pending != NO_ENTRY) {
+            l1->merges++;
+            eng->warp_link[w] = l1->entries[pending].waiters;
+            l1->entries[pending].waiters = w;
+        } else {
+            l1_allocate(eng, free_idx, w, now);
+        }
+    }
+}
+
+// --- Event Loop ---
+
+static void engine_free(timing_engine_t* eng) {
+    free(eng->head);
+    free(eng->next);
+    free(eng->warp_issue);
+    free(eng->warp_lookup);
+    free(eng->warp_line);
+    free(eng->warp_address);
+    free(eng->warp_level);
+    free(eng->warp_link);
+    free(eng->l1_link);
+    free(eng->tick_time);
+    pq_free(eng->events);
+}
+
+int timing_run(gpu_memory_system_t* system, memory_trace_t* traces, uint32_t begin, uint32_t end,
+               const timing_config_t* config, timing_stats_t* stats) {
+    memset(stats, 0, sizeof(*stats));
+    if (!system || !traces || end <= begin) return -1;
+
+    uint32_t warp_size = config->warp_size ? config->warp_size : TIMING_DEFAULT_WARP_SIZE;
+    uint32_t issue_width = config->issue_width ? config->issue_width : 1;
+    uint32_t warps_per_block = (MAX_THREADS + warp_size - 1) / warp_size;
+    uint32_t num_warps = warps_per_block * MAX_BLOCKS;
+    uint32_t channels = system->dram->config.channels;
+    uint32_t count = end - begin;
+
+    timing_engine_t eng;
+    memset(&eng, 0, sizeof(eng));
+    eng.system = system;
+    eng.stats = stats;
+    eng.head = (uint32_t*)malloc(num_warps * sizeof(uint32_t));
+    eng.next = (uint32_t*)malloc(count * sizeof(uint32_t));
+    eng.warp_issue = (uint64_t*)calloc(num_warps, sizeof(uint64_t));
+    eng.warp_lookup = (uint64_t*)calloc(num_warps, sizeof(uint64_t));
+    eng.warp_line = (uint64_t*)calloc(num_warps, sizeof(uint64_t));
+    eng.warp_address = (uint64_t*)calloc(num_warps, sizeof(uint64_t));
+    eng.warp_level = (mem_level_t*)calloc(num_warps, sizeof(mem_level_t));
+    eng.warp_link = (uint32_t*)calloc(num_warps, sizeof(uint32_t));
+    eng.tick_time = (uint64_t*)malloc(channels * sizeof(uint64_t));
+
+    bool ok = eng.head && eng.next && eng.warp_issue && eng.warp_lookup && eng.warp_line &&
+        eng.warp_address && eng.warp_level && eng.warp_link && eng.tick_time &&
+        mshr_init(&stats->l1_mshr, "L1", config->l1_mshrs) == 0 &&
+        mshr_init(&stats->l2_mshr, "L2", config->l2_mshrs) == 0 &&
+        port_init(&stats->l1_port, "L2 -> L1", config->l1_bandwidth) == 0 &&
+        port_init(&stats->l2_port, "DRAM -> L2", config->l2_bandwidth) == 0;
+    if (ok) {
+        eng.l1_link = (uint32_t*)calloc(stats->l1_mshr.count, sizeof(uint32_t));
+        eng.events = pq_create(num_warps + 2 * stats->l1_mshr.count + stats->l2_mshr.count + channels);
+        ok = eng.l1_link && eng.events;
+    }
+    if (!ok) {
+        engine_free(&eng);
+        timing_stats_free(stats);
+        printf("Error: Failed to allocate timing engine state.\n");
+        return -1;
+    }
+
+    // Per-warp FIFO of trace entries, as singly linked lists threaded through next[]
+    uint32_t* tail = eng.warp_link; // Free until the first miss
+    for (uint32_t w = 0; w < num_warps; w++) eng.head[w] = tail[w] = NO_ENTRY;
+    for (uint32_t i = 0; i < count; i++) {
+        memory_trace_t* trace = &traces[begin + i];
+        uint32_t w = (trace->block_id % MAX_BLOCKS) * warps_per_block + (trace->thread_id % MAX_THREADS) / warp_size;
+        eng.next[i] = NO_ENTRY;
+        if (tail[w] == NO_ENTRY) eng.head[w] = i;
+        else eng.next[tail[w]] = i;
+        tail[w] = i;
+    }
+
+    for (uint32_t c = 0; c < channels; c++) eng.tick_time[c] = UINT64_MAX;
+    for (uint32_t w = 0; w < num_warps; w++) {
+        if (eng.head[w] != NO_ENTRY) {
+            schedule(&eng, EVENT_ISSUE, w, 0);
+            stats->warps++;
+        }
+    }
+
+    uint64_t issue_slot = 0; // Next free issue slot (cycle * issue_width + lane)
+    uint64_t base_latency = system->total_latency;
+    stats->base_cycle = system->current_cycle;
+    system->defer_dram = true; // L2 misses go through the channel queues below
+
+    while (!pq_is_empty(eng.events) && !eng.failed) {
+        uint64_t now = eng.epoch + pq_peek_min_priority(eng.events);
+        uint32_t event = pq_extract_min(eng.events);
+        uint32_t idx = event & EVENT_INDEX_MASK;
+
+        // Shift the priority origin forward; all pending events are >= now, so order is preserved
+        if (now - eng.epoch > EPOCH_REBASE_THRESHOLD) {
+            pq_rebase(eng.events, (uint32_t)(now - eng.epoch));
+            eng.epoch = now;
+        }
+
+        switch ((event_type_t)(event >> EVENT_SHIFT)) {
+            case EVENT_ISSUE: {
+                uint64_t slot = max_u64(now * issue_width, issue_slot);
+                uint64_t issue = slot / issue_width;
+                issue_slot = slot + 1;
+                stats->issue_stall_cycles += issue - now;
+
+                uint32_t entry = eng.head[idx];
+                eng.head[idx] = eng.next[entry];
+                on_issue(&eng, idx, issue, &traces[begin + entry]);
+                break;
+            }
+            case EVENT_L1_LOOKUP: on_l1_lookup(&eng, idx, now); break;
+            case EVENT_L2_LOOKUP: on_l2_lookup(&eng, idx, now); break;
+            case EVENT_DRAM:      on_dram(&eng, idx, now); break;
+            case EVENT_L2_FILL:   on_l2_fill(&eng, idx, now); break;
+            case EVENT_L1_FILL:   on_l1_fill(&eng, idx, now); break;
+        }
+    }
+
+    system->defer_dram = false;
+    int result = 0;
+    if (eng.failed) {
+        printf("Error: Timing engine ran out of memory.\n");
+        result = -1;
+    }
+
+    // Report engine time instead of the serialized sum accumulated by gpu_memory_access
+    system->total_latency = base_latency + stats->total_latency;
+    system->current_cycle = stats->base_cycle + stats->makespan;
+
+    engine_free(&eng);
+    if (result != 0) timing_stats_free(stats);
+    return result;
+}
+
+void timing_print_stats(const timing_stats_t* stats, const timing_config_t* config) {
+    double makespan = stats->makespan ? (double)stats->makespan : 1.0;
+
+    printf("\nEvent-Driven Timing\n");
+    printf("===================\n");
+    printf("Warps: %lu (warp size %u), Issue Width: %u/cycle\n", stats->warps, config->warp_size, config->issue_width);
+    printf("Total Cycles (makespan): %lu\n", stats->makespan);
+    printf("Accesses: %lu, Throughput: %.3f accesses/cycle\n", stats->accesses, stats->accesses / makespan);
+    printf("AMAT (issue to completion): %.2f cycles\n",
+        stats->accesses ? (double)stats->total_latency / stats->accesses : 0.0);
+    printf("Issue Stall Cycles: %lu\n\n", stats->issue_stall_cycles);
+
+    const mshr_table_t* tables[2] = { &stats->l1_mshr, &stats->l2_mshr };
+    for (int i = 0; i < 2; i++) {
+        const mshr_table_t* t = tables[i];
+        printf("%s MSHRs (%u entries):\n", t->name, t->count);
+        printf("  Allocations: %lu, Merged Requests: %lu\n", t->allocations, t->merges);
+        printf("  Avg Occupancy: %.2f, Peak Occupancy: %u\n", t->busy_cycles / makespan, t->peak_occupancy);
+        printf("  Full Cycles: %lu (%.1f%% of makespan)\n", t->full_cycles, t->full_cycles / makespan * 100.0);
+        printf("  Request Wait Cycles: %lu (summed over waiting %s)\n\n", t->wait_cycles, i == 0 ? "warps" : "L1 misses");
+    }
+
+    const bandwidth_port_t* ports[2] = { &stats->l1_port, &stats->l2_port };
+    for (int i = 0; i < 2; i++) {
+        const bandwidth_port_t* p = ports[i];
+        printf("%s Bandwidth:\n", p->name);
+        if (p->bytes_per_cycle) {
+            printf("  Achieved: %.2f B/cycle of %u B/cycle (%.1f%% utilized)\n",
+                p->bytes / makespan, p->bytes_per_cycle, p->bytes / makespan / p->bytes_per_cycle * 100.0);
+        } else {
+            printf("  Achieved: %.2f B/cycle (unlimited)\n", p->bytes / makespan);
+        }
+        printf("  Bytes: %lu, Queueing Cycles: %lu\n\n", p->bytes, p->queue_cycles);
+    }
+}
+
+void timing_stats_free(timing_stats_t* stats) {
+    free(stats->l1_mshr.entries);
+    free(stats->l2_mshr.entries);
+    if (stats->l1_mshr.index) hash_table_free(stats->l1_mshr.index);
+    if (stats->l2_mshr.index) hash_table_free(stats->l2_mshr.index);
+    stats->l1_mshr.entries = NULL;
+    stats->l2_mshr.entries = NULL;
+    stats->l1_mshr.index = NULL;
+    stats->l2_mshr.index = NULL;
+
+    bandwidth_port_t* ports[2] = { &stats->l1_port, &stats->l2_port };
+    for (int i = 0; i < 2; i++) {
+        free(ports[i]->slot_cycle);
+        free(ports[i]->slot_used);
+        ports[i]->slot_cycle = NULL;
+        ports[i]->slot_used = NULL;
+    }
+}
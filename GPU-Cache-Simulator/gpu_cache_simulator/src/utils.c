@@ -1,4 +1,5 @@
 #include "utils.h"
+#include "profiler.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -38,15 +39,19 @@ int load_memory_trace(const char* filename, memory_trace_t** traces, uint32_t* c
     while (fgets(line, sizeof(line), file) && idx < *count) {
         if (line[0] == '#' || line[0] == '\n') continue;
 
-        int result = sscanf(line, "%c %lx %u %u %u",
+        PROF_BEGIN(PROF_TRACE_PARSE);
+        (*traces)[idx].stream_id = 0;
+        int result = sscanf(line, "%c %lx %u %u %u %u",
             &(*traces)[idx].operation,
             &(*traces)[idx].address,
             &(*traces)[idx].size,
             &(*traces)[idx].thread_id,
-            &(*traces)[idx].block_id
+            &(*traces)[idx].block_id,
+            &(*traces)[idx].stream_id
         );
+        PROF_END(PROF_TRACE_PARSE);
 
-        if (result == 5) {
+        if (result == 5 || result == 6) {
             idx++;
         } else {
             printf("Warning: Skipped invalid line %u in trace file: %s", idx + 1, line);
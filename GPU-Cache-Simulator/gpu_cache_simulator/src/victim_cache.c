@@ -0,0 +1,131 @@
+#include "victim_cache.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+victim_cache_t* victim_cache_create(uint32_t capacity, uint32_t latency) {
+    if (capacity == 0) {
+        printf("Error: A victim cache needs at least one entry\n");
+        return NULL;
+    }
+
+    victim_cache_t* vc = (victim_cache_t*)calloc(1, sizeof(victim_cache_t));
+    if (!vc) return NULL;
+    vc->capacity = capacity;
+    vc->latency = latency;
+
+    vc->entries = (victim_entry_t*)malloc(capacity * sizeof(victim_entry_t));
+    vc->index = hash_table_create(capacity * 2 + 1); // Short chains at full occupancy
+    if (!vc->entries || !vc->index) {
+        victim_cache_free(vc);
+        return NULL;
+    }
+    vc->mru = VICTIM_NONE;
+    victim_cache_clear(vc);
+    return vc;
+}
+
+void victim_cache_clear(victim_cache_t* vc) {
+    for (uint32_t i = vc->mru; i != VICTIM_NONE; i = vc->entries[i].next) hash_table_delete(vc->index, vc->entries[i].line);
+    for (uint32_t i = 0; i < vc->capacity; i++) vc->entries[i].next = i + 1 < vc->capacity ? i + 1 : VICTIM_NONE;
+    vc->free_head = 0;
+    vc->mru = vc->lru = VICTIM_NONE;
+    vc->count = 0;
+}
+
+void victim_cache_reset(victim_cache_t* vc) {
+    if (!vc) return;
+    victim_cache_clear(vc);
+    vc->probes = vc->hits = vc->partial_hits = vc->inserts = 0;
+    vc->evictions = vc->dirty_evictions = vc->invalidations = 0;
+}
+
+static void victim_unlink(victim_cache_t* vc, uint32_t i) {
+    victim_entry_t* e = &vc->entries[i];
+    if (e->prev != VICTIM_NONE) vc->entries[e->prev].next = e->next;
+    else vc->mru = e->next;
+    if (e->next != VICTIM_NONE) vc->entries[e->next].prev = e->prev;
+    else vc->lru = e->prev;
+}
+
+static void victim_push_mru(victim_cache_t* vc, uint32_t i) {
+    victim_entry_t* e = &vc->entries[i];
+    e->prev = VICTIM_NONE;
+    e->next = vc->mru;
+    if (vc->mru != VICTIM_NONE) vc->entries[vc->mru].prev = i;
+    vc->mru = i;
+    if (vc->lru == VICTIM_NONE) vc->lru = i;
+}
+
+// Unlinks entry i, drops it from the index and returns it to the free list
+static void victim_remove(victim_cache_t* vc, uint32_t i) {
+    victim_unlink(vc, i);
+    hash_table_delete(vc->index, vc->entries[i].line);
+    vc->entries[i].next = vc->free_head;
+    vc->free_head = i;
+    vc->count--;
+}
+
+bool victim_cache_take(victim_cache_t* vc, uint64_t line, victim_entry_t* out) {
+    vc->probes++;
+    uint32_t i = hash_table_lookup(vc->index, line);
+    if (i == UINT32_MAX) return false;
+    *out = vc->entries[i];
+    victim_remove(vc, i);
+    return true;
+}
+
+bool victim_cache_invalidate(victim_cache_t* vc, uint64_t line, uint32_t* sector_dirty) {
+    uint32_t i = hash_table_lookup(vc->index, line);
+    if (i == UINT32_MAX) return false;
+    *sector_dirty = vc->entries[i].sector_dirty;
+    victim_remove(vc, i);
+    vc->invalidations++;
+    return true;
+}
+
+bool victim_cache_insert(victim_cache_t* vc, uint64_t line, uint32_t sector_valid, uint32_t sector_dirty,
+                         victim_entry_t* displaced) {
+    vc->inserts++;
+    uint32_t i = hash_table_lookup(vc->index, line);
+    if (i != UINT32_MAX) {
+        vc->entries[i].sector_valid |= sector_valid;
+        vc->entries[i].sector_dirty |= sector_dirty;
+        victim_unlink(vc, i);
+        victim_push_mru(vc, i);
+        return false;
+    }
+
+    bool full = vc->free_head == VICTIM_NONE;
+    if (full) {
+        *displaced = vc->entries[vc->lru];
+        vc->evictions++;
+        if (displaced->sector_dirty) vc->dirty_evictions++;
+        victim_remove(vc, vc->lru);
+    }
+
+    i = vc->free_head;
+    vc->free_head = vc->entries[i].next;
+    vc->entries[i].line = line;
+    vc->entries[i].sector_valid = sector_valid;
+    vc->entries[i].sector_dirty = sector_dirty;
+    victim_push_mru(vc, i);
+    hash_table_insert(vc->index, line, i);
+    vc->count++;
+    return full;
+}
+
+void victim_cache_print_stats(const victim_cache_t* vc) {
+    printf("  Victim Cache: %u entries (%u in use), +%u cycles\n", vc->capacity, vc->count, vc->latency);
+    printf("  Victim Hits: %lu of %lu probes (%.2f%%), %lu partial; next-level accesses avoided: %lu\n",
+        vc->hits, vc->probes, vc->probes ? (double)vc->hits / vc->probes * 100.0 : 0.0,
+        vc->partial_hits, vc->hits);
+    printf("  Victim Evictions: %lu (%lu dirty), Back-Invalidated: %lu\n",
+        vc->evictions, vc->dirty_evictions, vc->invalidations);
+}
+
+void victim_cache_free(victim_cache_t* vc) {
+    if (!vc) return;
+    free(vc->entries);
+    if (vc->index) hash_table_free(vc->index);
+    free(vc);
+}